@@ -0,0 +1,112 @@
+#version 120
+
+// Displaces the rest mesh with looping 4D noise as it's drawn, the same way
+// ofApp::modulateDelaunay() does on the CPU. Plain GLSL 1.20 through the
+// fixed function attributes, so it runs under Mesa's software GL too.
+//
+// The noise is ofSignedNoise() itself, ported from ofNoise with the same
+// permutation, gradients and skewing, so the GPU displaces by the same field
+// as the CPU. GLSL 1.20 has no integer bit operations, so the hashing is
+// done in floats, which hold every value it needs exactly. The permutation
+// comes in from NoiseKernels as a uniform, four entries to a vec4.
+
+uniform float noiseScale;
+uniform float noiseRadius;
+uniform float noiseAmt;
+uniform float loopPhase;        // 0 to 1 over the animation loop
+uniform int noiseMode;          // 1 == (X, Z, Y, Z), 0 == (X, Y, X, Y)
+uniform vec4 perm[64];          // Ken Perlin's permutation
+
+const float TWO_PI = 6.28318530717958647693;
+
+// Skewing and unskewing factors for 4D, exactly as ofNoise has them
+const float F4 = 0.309016994;
+const float G4 = 0.138196601;
+
+float permute(float i){
+    i = mod(i, 256.0);
+    vec4 p = perm[int(i * 0.25)];
+    float c = mod(i, 4.0);
+    return c < 1.0 ? p.x : (c < 2.0 ? p.y : (c < 3.0 ? p.z : p.w));
+}
+
+// Like ofNoise's FASTFLOOR, 0 and negative integers round down a whole step
+float fastFloor(float x){
+    return x > 0.0 ? floor(x) : ceil(x) - 1.0;
+}
+
+// h & n, for n a power of two
+float bit(float h, float n){
+    return mod(floor(h / n), 2.0);
+}
+
+// One of 32 gradient directions, dotted with the offset
+float grad4(float hash, vec4 p){
+    float h = mod(hash, 32.0);
+    float u = h < 24.0 ? p.x : p.y;
+    float v = h < 16.0 ? p.y : p.z;
+    float w = h < 8.0 ? p.z : p.w;
+    return (bit(h, 1.0) > 0.0 ? -u : u) + (bit(h, 2.0) > 0.0 ? -v : v) + (bit(h, 4.0) > 0.0 ? -w : w);
+}
+
+float corner(float hash, vec4 p){
+    float t = 0.6 - p.x * p.x - p.y * p.y - p.z * p.z - p.w * p.w;
+    if (t < 0.0) return 0.0;
+    t *= t;
+    return t * t * grad4(hash, p);
+}
+
+float hashCorner(vec4 cell, vec4 offset){
+    vec4 c = cell + offset;
+    return permute(c.x + permute(c.y + permute(c.z + permute(c.w))));
+}
+
+float signedNoise(vec4 v){
+
+    // Which cell of 24 simplices the point is in
+    float s = (v.x + v.y + v.z + v.w) * F4;
+    vec4 i = vec4(fastFloor(v.x + s), fastFloor(v.y + s), fastFloor(v.z + s), fastFloor(v.w + s));
+    float t = (i.x + i.y + i.z + i.w) * G4;
+    vec4 x0 = v - (i - t);
+
+    // Which simplex in the cell, from the order of the offsets
+    vec4 rank = vec4(0.0);
+    if (x0.x > x0.y) rank.x++; else rank.y++;
+    if (x0.x > x0.z) rank.x++; else rank.z++;
+    if (x0.x > x0.w) rank.x++; else rank.w++;
+    if (x0.y > x0.z) rank.y++; else rank.z++;
+    if (x0.y > x0.w) rank.y++; else rank.w++;
+    if (x0.z > x0.w) rank.z++; else rank.w++;
+
+    vec4 i1 = step(3.0, rank);
+    vec4 i2 = step(2.0, rank);
+    vec4 i3 = step(1.0, rank);
+
+    vec4 cell = mod(i, 256.0);
+    float n0 = corner(hashCorner(cell, vec4(0.0)), x0);
+    float n1 = corner(hashCorner(cell, i1), x0 - i1 + G4);
+    float n2 = corner(hashCorner(cell, i2), x0 - i2 + 2.0 * G4);
+    float n3 = corner(hashCorner(cell, i3), x0 - i3 + 3.0 * G4);
+    float n4 = corner(hashCorner(cell, vec4(1.0)), x0 - 1.0 + 4.0 * G4);
+    return 27.0 * (n0 + n1 + n2 + n3 + n4);
+}
+
+void main(){
+    vec4 p = gl_Vertex;
+
+    // Round a circle in the noise's last two dimensions once per loop
+    vec2 loop = noiseRadius * vec2(sin(TWO_PI * loopPhase), cos(TWO_PI * loopPhase));
+
+    if (noiseMode == 1){
+        p.x += noiseAmt * signedNoise(vec4(noiseScale * p.x, noiseScale * p.z, loop));
+        p.y += noiseAmt * signedNoise(vec4(noiseScale * p.y, noiseScale * p.z, loop));
+    }
+    else {
+        // y's noise is looked up from the x that's already been moved
+        p.x += noiseAmt * signedNoise(vec4(noiseScale * p.x, noiseScale * p.y, loop));
+        p.y += noiseAmt * signedNoise(vec4(noiseScale * p.x, noiseScale * p.y, loop));
+    }
+
+    gl_Position = gl_ModelViewProjectionMatrix * p;
+    gl_FrontColor = gl_Color;   // Flat shading still picks the provoking vertex's
+}
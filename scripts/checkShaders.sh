@@ -0,0 +1,17 @@
+#!/bin/sh
+# Compiles every shader in bin/data/shaders with glslangValidator, from
+# Khronos' glslang, and exits non-zero if any of them fail. The stage comes
+# from the extension and the GLSL version from each shader's #version.
+
+cd "$(dirname "$0")/.." || exit 1
+
+if ! command -v glslangValidator > /dev/null; then
+    echo "glslangValidator not found, install glslang-tools" >&2
+    exit 1
+fi
+
+status=0
+for shader in bin/data/shaders/*.vert bin/data/shaders/*.frag; do
+    glslangValidator "$shader" || status=1
+done
+exit $status
@@ -0,0 +1,172 @@
+#include "AdaptiveSampler.h"
+
+// More than any depth or colour change inside the subject will score
+static const float SILHOUETTE_DETAIL = 1000;
+
+//--------------------------------------------------------------
+AdaptiveSampler::AdaptiveSampler()
+:frame(NULL)
+,mask(NULL)
+,near(0)
+,far(0)
+,width(0)
+,height(0)
+,vertexBudget(6000)
+,minCellSize(2)
+,maxCellSize(32)
+,depthStep(15)
+,lumaStep(24){
+}
+
+//--------------------------------------------------------------
+void AdaptiveSampler::setVertexBudget(int budget){
+    vertexBudget = budget;
+}
+
+//--------------------------------------------------------------
+int AdaptiveSampler::getVertexBudget() const {
+    return vertexBudget;
+}
+
+//--------------------------------------------------------------
+void AdaptiveSampler::setCellSizes(int minimum, int maximum){
+    minCellSize = max(1, minimum);
+    maxCellSize = max(minCellSize, maximum);
+}
+
+//--------------------------------------------------------------
+void AdaptiveSampler::sample(const KinectFrame& frame, const unsigned char* mask, float near, float far, vector<ofPoint>& points){
+
+    this->frame = &frame;
+    this->mask = mask;
+    this->near = near;
+    this->far = far;
+    width = frame.getWidth();
+    height = frame.getHeight();
+
+    queue.clear();
+    leaves.clear();
+    taken.assign(width * height, 0);
+
+    // Start from a coarse grid. Every cell adds at most five new corners when
+    // it splits, its centre and the middle of each side, which is what the
+    // budget is counted in.
+    int cellsX = (width + maxCellSize - 1) / maxCellSize;
+    int cellsY = (height + maxCellSize - 1) / maxCellSize;
+    int vertices = (cellsX + 1) * (cellsY + 1);
+
+    // Each split spends five of the budget on at most four new cells, so
+    // there can't be more than this. Reserving it up front keeps a settled
+    // sampler off the heap whatever the frame looks like.
+    size_t maxCells = cellsX * cellsY + 4 * (max(0, vertexBudget - vertices) / 5 + 1);
+    queue.reserve(maxCells);
+    leaves.reserve(maxCells);
+    for (int cy = 0; cy < cellsY; cy++){
+        for (int cx = 0; cx < cellsX; cx++){
+            Cell cell = measure(cx * maxCellSize, cy * maxCellSize, maxCellSize);
+            if (cell.detail < 0) continue;  // Nothing of the subject in it
+            queue.push_back(cell);
+        }
+    }
+    make_heap(queue.begin(), queue.end());
+
+    // Split the most detailed cell until nothing is worth splitting or the
+    // budget runs out
+    while (!queue.empty()){
+        pop_heap(queue.begin(), queue.end());
+        Cell cell = queue.back();
+        queue.pop_back();
+
+        if (cell.size <= minCellSize || cell.detail < 1 || vertices + 5 > vertexBudget){
+            leaves.push_back(cell);
+            continue;
+        }
+
+        int half = cell.size / 2;
+        vertices += 5;
+        for (int i = 0; i < 4; i++){
+            Cell child = measure(cell.x + (i % 2) * half, cell.y + (i / 2) * half, half);
+            if (child.detail < 0) continue;
+            queue.push_back(child);
+            push_heap(queue.begin(), queue.end());
+        }
+    }
+
+    // Every leaf's corners go in once, wherever they're on the subject
+    for (size_t i = 0; i < leaves.size(); i++){
+        const Cell& cell = leaves[i];
+        addPoint(cell.x, cell.y, points);
+        addPoint(cell.x + cell.size, cell.y, points);
+        addPoint(cell.x, cell.y + cell.size, points);
+        addPoint(cell.x + cell.size, cell.y + cell.size, points);
+    }
+}
+
+//--------------------------------------------------------------
+AdaptiveSampler::Cell AdaptiveSampler::measure(int x, int y, int size){
+
+    // The corners and centre are enough to tell a flat cell from one with
+    // an edge running through it
+    const int corners[4][2] = { {0, 0}, {1, 0}, {0, 1}, {1, 1} };
+    float minDepth = far, maxDepth = 0;
+    float minLuma = 255, maxLuma = 0;
+    int onSubject = 0;
+    for (int i = 0; i < 5; i++){
+        int sx = i < 4 ? x + corners[i][0] * size : x + size / 2;
+        int sy = i < 4 ? y + corners[i][1] * size : y + size / 2;
+        float depth = getDepth(sx, sy);
+        if (depth > 0){
+            minDepth = min(minDepth, depth);
+            maxDepth = max(maxDepth, depth);
+            onSubject++;
+        }
+        float luma = getLuma(sx, sy);
+        minLuma = min(minLuma, luma);
+        maxLuma = max(maxLuma, luma);
+    }
+
+    Cell cell;
+    cell.x = x;
+    cell.y = y;
+    cell.size = size;
+    if (onSubject == 0){
+        cell.detail = -1;
+    }
+    else if (onSubject < 5){
+        cell.detail = SILHOUETTE_DETAIL;    // Always worth refining
+    }
+    else {
+        cell.detail = (maxDepth - minDepth) / depthStep + (maxLuma - minLuma) / lumaStep;
+    }
+    return cell;
+}
+
+//--------------------------------------------------------------
+float AdaptiveSampler::getDepth(int x, int y) const {
+    x = min(x, width - 1);
+    y = min(y, height - 1);
+    if (mask[x + y * width] == 0) return 0;
+    float depth = frame->getDistanceAt(x, y);
+    return depth > near && depth < far ? depth : 0;
+}
+
+//--------------------------------------------------------------
+float AdaptiveSampler::getLuma(int x, int y) const {
+    x = min(x, width - 1);
+    y = min(y, height - 1);
+    ofColor c = frame->getColorAt(x, y);
+    return (c.r * 2 + c.g * 5 + c.b) / 8.0;
+}
+
+//--------------------------------------------------------------
+void AdaptiveSampler::addPoint(int x, int y, vector<ofPoint>& points){
+    x = min(x, width - 1);
+    y = min(y, height - 1);
+    unsigned char& t = taken[x + y * width];
+    if (t) return;
+    t = 1;
+
+    float depth = getDepth(x, y);
+    if (depth == 0) return;
+    points.push_back(ofPoint(x - width / 2.0, y - height / 2.0, -depth));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ofMain.h"
+#include "KinectFrame.h"
+
+// Picks the points to triangulate with a quadtree over the depth image
+// rather than a uniform grid. Cells are split where the depth or the colour
+// changes across them, nose, jaw line, eyes, the edge of the silhouette, and
+// left coarse over cheeks and foreheads. The most detailed cells are split
+// first, and splitting stops at the vertex budget, so the triangle count has
+// a hard ceiling however busy the frame is.
+
+class AdaptiveSampler {
+
+    public:
+        AdaptiveSampler();
+
+        // Appends the chosen points to `points`, in the same space as the
+        // uniform sampling: centred on the image, z pushed back by depth
+        void sample(const KinectFrame& frame, const unsigned char* mask, float near, float far, vector<ofPoint>& points);
+
+        void setVertexBudget(int budget);
+        int getVertexBudget() const;
+        void setCellSizes(int minimum, int maximum);    // Pixels, powers of two
+
+    private:
+        struct Cell {
+            int x, y, size;
+            float detail;
+            bool operator<(const Cell& other) const { return detail * size < other.detail * other.size; }
+        };
+
+        Cell measure(int x, int y, int size);
+        float getDepth(int x, int y) const;
+        float getLuma(int x, int y) const;
+        void addPoint(int x, int y, vector<ofPoint>& points);
+
+        const KinectFrame* frame;
+        const unsigned char* mask;
+        float near;
+        float far;
+        int width;
+        int height;
+
+        int vertexBudget;
+        int minCellSize;
+        int maxCellSize;
+        float depthStep;        // Depth change across a cell worth a split, in millimetres
+        float lumaStep;         // Same for brightness, 0-255
+
+        vector<Cell> queue;     // Max heap on detail, cells that could still split
+        vector<Cell> leaves;    // Cells that won't be split any further
+        vector<unsigned char> taken;    // Pixels already emitted this frame, cells share corners
+};
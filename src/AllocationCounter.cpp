@@ -0,0 +1,138 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+
+#ifdef CAPGRAS_ALLOCATION_COUNTER
+
+// Plain __thread rather than thread_local, a POD counter doesn't need more
+static __thread uint64_t threadCount = 0;
+
+static void* allocate(std::size_t size){
+    threadCount++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size){
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size){
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    threadCount++;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    threadCount++;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* p, std::size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    free(p);
+}
+#endif
+
+#if defined(__cpp_aligned_new)
+// Over-aligned types come through here from C++17 on, and get counted too
+static void* allocateAligned(std::size_t size, std::align_val_t alignment){
+    threadCount++;
+    void* p = NULL;
+    std::size_t align = std::max((std::size_t)alignment, sizeof(void*));
+    if (posix_memalign(&p, align, size == 0 ? 1 : size) != 0) return NULL;
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment){
+    void* p = allocateAligned(size, alignment);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment){
+    void* p = allocateAligned(size, alignment);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(p);
+}
+#endif
+
+//--------------------------------------------------------------
+uint64_t AllocationCounter::getThreadCount(){
+    return threadCount;
+}
+
+//--------------------------------------------------------------
+bool AllocationCounter::isEnabled(){
+    return true;
+}
+
+#else
+
+uint64_t AllocationCounter::getThreadCount(){
+    return 0;
+}
+
+bool AllocationCounter::isEnabled(){
+    return false;
+}
+
+#endif
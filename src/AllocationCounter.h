@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts heap allocations made through operator new, per thread, so we can
+// check which parts of the pipeline touch the heap and prove the ones that
+// shouldn't don't. It replaces the global operators, so it's only built in
+// when CAPGRAS_ALLOCATION_COUNTER is defined, e.g. PROJECT_DEFINES in
+// config.make for a profiling build.
+
+namespace AllocationCounter {
+
+    // Allocations made by the calling thread since it started
+    uint64_t getThreadCount();
+
+    bool isEnabled();
+}
@@ -0,0 +1,828 @@
+#include "Benchmarks.h"
+#include "DepthKernels.h"
+#include "ColorKernels.h"
+#include "GridMesher.h"
+#include "TiledDelaunay.h"
+#include "ThreadPool.h"
+#include "AdaptiveSampler.h"
+#include "MaskCoverage.h"
+#include "TriangleCompactor.h"
+#include "NoiseKernels.h"
+#include "MeshModulator.h"
+#include "NoiseVolume.h"
+#include "ofxDelaunay.h"
+
+static const int ITERATIONS = 200;
+
+// Checks that came out wrong since runAll() started
+static int numFailures = 0;
+
+// Mean microseconds per call of f over a number of calls
+template<typename F>
+static double timeMicros(F f, int iterations = ITERATIONS){
+    f(); // Warm the caches up first
+    uint64_t start = ofGetElapsedTimeMicros();
+    for (int i = 0; i < iterations; i++) f();
+    return (ofGetElapsedTimeMicros() - start) / (double)iterations;
+}
+
+static void logResult(const string& name, double micros, double baseline){
+    ofLogNotice("Benchmarks") << "    " << name << ": " << ofToString(micros, 1) << " us"
+                              << " (" << ofToString(baseline / micros, 1) << "x)";
+}
+
+// Sample the masked depth the way updateDelaunay() does
+static void samplePoints(const KinectFrame& frame, const vector<unsigned char>& mask, int spacing,
+                         const Benchmarks::Settings& settings, vector<ofPoint>& points){
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+    points.clear();
+    for (int x = 0; x < width; x += spacing){
+        for (int y = 0; y < height; y += spacing){
+            if (mask[x + y * width] == 0) continue;
+            float distance = frame.getDistanceAt(x, y);
+            if (distance > settings.depthNear && distance < settings.depthFar){
+                points.push_back(ofPoint(x - width / 2.0, y - height / 2.0, -distance));
+            }
+        }
+    }
+}
+
+// Screen area of a triangle if it survives updateDelaunay()'s mask test, 0 if not
+static float coveredArea(const ofVec3f& p1, const ofVec3f& p2, const ofVec3f& p3,
+                         const vector<unsigned char>& mask, int width, int height){
+    int cx = ofClamp((p1.x + p2.x + p3.x) / 3.0 + width / 2, 0, width - 1);
+    int cy = ofClamp((p1.y + p2.y + p3.y) / 3.0 + height / 2, 0, height - 1);
+    if (mask[cx + cy * width] == 0) return 0;
+    return fabs((p2.x - p1.x) * (p3.y - p1.y) - (p3.x - p1.x) * (p2.y - p1.y)) / 2;
+}
+
+// How well a triangulation stands in for the depth image: the mean distance
+// between the mesh and the real depth over the masked pixels it covers
+static double meanDepthError(const ofMesh& mesh, const KinectFrame& frame, const vector<unsigned char>& mask){
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+    double error = 0;
+    int covered = 0;
+    for (size_t i = 0; i + 2 < mesh.getNumIndices(); i += 3){
+        ofVec3f a = mesh.getVertex(mesh.getIndex(i)) + ofVec3f(width / 2, height / 2);
+        ofVec3f b = mesh.getVertex(mesh.getIndex(i + 1)) + ofVec3f(width / 2, height / 2);
+        ofVec3f c = mesh.getVertex(mesh.getIndex(i + 2)) + ofVec3f(width / 2, height / 2);
+        float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+        if (area == 0) continue;
+
+        int x0 = max(0, (int)floor(min(a.x, min(b.x, c.x))));
+        int x1 = min(width - 1, (int)ceil(max(a.x, max(b.x, c.x))));
+        int y0 = max(0, (int)floor(min(a.y, min(b.y, c.y))));
+        int y1 = min(height - 1, (int)ceil(max(a.y, max(b.y, c.y))));
+        for (int y = y0; y <= y1; y++){
+            for (int x = x0; x <= x1; x++){
+                if (mask[x + y * width] == 0) continue;
+                float u = ((b.x - x) * (c.y - y) - (c.x - x) * (b.y - y)) / area;
+                float v = ((c.x - x) * (a.y - y) - (a.x - x) * (c.y - y)) / area;
+                float w = 1 - u - v;
+                if (u < 0 || v < 0 || w < 0) continue;
+                float depth = -(u * a.z + v * b.z + w * c.z);
+                error += fabs(depth - frame.getDistanceAt(x, y));
+                covered++;
+            }
+        }
+    }
+    return covered > 0 ? error / covered : 0;
+}
+
+// Times run(set) on every instruction set up to best that the machine has,
+// against the baseline. check(set) then compares what it left against the
+// reference, logs any mismatch and returns the name to log the time under.
+template<typename Run, typename Check>
+static void timeInstructionSets(DepthKernels::InstructionSet best, double baseline, int iterations, Run run, Check check){
+    for (int set = DepthKernels::SCALAR; set <= best; set++){
+        DepthKernels::InstructionSet s = (DepthKernels::InstructionSet)set;
+        if (!DepthKernels::isAvailable(s)) continue;
+        double micros = timeMicros([&]{ run(s); }, iterations);
+        logResult(check(s), micros, baseline);
+    }
+}
+
+// Runs f(pool, threads) on pools of one, two, four and eight threads, as
+// many of those as there are cores for
+template<typename F>
+static void eachThreadPool(F f){
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= std::min(cores, 8); threads *= 2){
+        ThreadPool pool;
+        pool.setup(threads);
+        f(pool, threads);
+    }
+}
+
+// The mask updateDelaunay() thresholds the depth into
+static void thresholdMask(const KinectFrame& frame, const Benchmarks::Settings& settings, vector<unsigned char>& mask){
+    mask.resize(frame.getWidth() * frame.getHeight());
+    DepthKernels::threshold(frame.rawDepth.getData(), mask.size(), settings.depthNear, settings.depthFar, &mask[0]);
+}
+
+// The mask and the grid mesher's triangles over it, which most of the
+// benchmarks work on. False, with a warning, if the frame has no subject.
+static bool meshGrid(const KinectFrame& frame, const Benchmarks::Settings& settings, int spacing,
+                     vector<unsigned char>& mask, GridMesher& grid){
+    thresholdMask(frame, settings, mask);
+    grid.update(frame, &mask[0], spacing, settings.depthNear, settings.depthFar);
+    if (grid.getNumTriangles() == 0){
+        ofLogWarning("Benchmarks") << "no subject in the frame to mesh";
+        return false;
+    }
+    return true;
+}
+
+// Each of the grid's triangles as its three corners in a row, the way
+// MaskCoverage takes them
+static void gatherCorners(const GridMesher& grid, vector<ofVec3f>& corners){
+    const vector<ofVec3f>& verts = grid.getVertices();
+    const vector<int>& indices = grid.getIndices();
+    corners.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) corners[i] = verts[indices[i]];
+}
+
+// A triangle as one number from its corners' samples, the same whichever way
+// round it's wound
+static uint64_t triangleKey(int a, int b, int c, int numSamples){
+    if (a > b) std::swap(a, b);
+    if (b > c) std::swap(b, c);
+    if (a > b) std::swap(a, b);
+    return ((uint64_t)a * numSamples + b) * numSamples + c;
+}
+
+// Every triangle the tiles and the seams between them came out with, sorted
+// so two triangulations of the same samples can be compared
+static void gatherTiledTriangles(const TiledDelaunay& tiled, vector<uint64_t>& triangles){
+    int n = tiled.getNumSamples();
+    triangles.clear();
+    const vector<TiledDelaunay::Tile>& tiles = tiled.getTiles();
+    for (size_t t = 0; t < tiles.size(); t++){
+        const TiledDelaunay::Tile& tile = tiles[t];
+        for (size_t i = 0; i + 2 < tile.indices.size(); i += 3){
+            triangles.push_back(triangleKey(tile.samples[tile.indices[i]], tile.samples[tile.indices[i + 1]],
+                                            tile.samples[tile.indices[i + 2]], n));
+        }
+    }
+    const vector<int>& seams = tiled.getSeamIndices();
+    for (size_t i = 0; i + 2 < seams.size(); i += 3){
+        triangles.push_back(triangleKey(seams[i], seams[i + 1], seams[i + 2], n));
+    }
+    std::sort(triangles.begin(), triangles.end());
+}
+
+// The samples the tiles triangulated, nudged the same way, but triangulated
+// in one go
+static void triangulateWhole(const TiledDelaunay& tiled, vector<uint64_t>& triangles){
+    int n = tiled.getNumSamples();
+    vector<bool> bSeen(n, false);
+    vector<int> samples;
+    vector<ofPoint> lattice;
+    const vector<TiledDelaunay::Tile>& tiles = tiled.getTiles();
+    for (size_t t = 0; t < tiles.size(); t++){
+        const vector<int>& tileSamples = tiles[t].samples;
+        for (size_t j = 0; j < tileSamples.size(); j++){
+            if (bSeen[tileSamples[j]]) continue;
+            bSeen[tileSamples[j]] = true;
+            samples.push_back(tileSamples[j]);
+            lattice.push_back(tiled.getLatticePoint(tileSamples[j]));
+        }
+    }
+
+    triangles.clear();
+    if (lattice.size() < 3) return;
+    ofxDelaunay del;
+    del.addPoints(lattice);
+    del.triangulate();
+    const ofMesh& mesh = del.triangleMesh;
+    for (size_t i = 0; i + 2 < mesh.getNumIndices(); i += 3){
+        triangles.push_back(triangleKey(samples[mesh.getIndex(i)], samples[mesh.getIndex(i + 1)],
+                                        samples[mesh.getIndex(i + 2)], n));
+    }
+    std::sort(triangles.begin(), triangles.end());
+}
+
+// How much of the mask a tiled triangulation's triangles cover
+static float tiledCoverage(const TiledDelaunay& tiled, const vector<uint64_t>& triangles,
+                         const vector<unsigned char>& mask, int width, int height){
+    uint64_t n = tiled.getNumSamples();
+    float area = 0;
+    for (size_t i = 0; i < triangles.size(); i++){
+        area += coveredArea(tiled.getSample(triangles[i] / (n * n)), tiled.getSample(triangles[i] / n % n),
+                            tiled.getSample(triangles[i] % n), mask, width, height);
+    }
+    return area;
+}
+
+// Samples the mask and triangulates the points the way updateDelaunay() does,
+// leaving del empty if there's too few of them
+static void triangulate(const KinectFrame& frame, const vector<unsigned char>& mask, int spacing,
+                        const Benchmarks::Settings& settings, vector<ofPoint>& points, ofxDelaunay& del){
+    samplePoints(frame, mask, spacing, settings, points);
+    del.reset();
+    if (points.size() < 3) return;
+    del.addPoints(points);
+    del.triangulate();
+}
+
+// What modulateDelaunay() displaces by at time t round the noise loop
+static NoiseKernels::Displacement displacementAt(const Benchmarks::Settings& settings, float t, bool bXZ){
+    NoiseKernels::Displacement displacement;
+    displacement.scale = settings.noiseScale;
+    displacement.amount = settings.noiseAmt;
+    displacement.loopZ = settings.noiseRadius * sin(TWO_PI * t);
+    displacement.loopW = settings.noiseRadius * cos(TWO_PI * t);
+    displacement.bXZ = bXZ;
+    return displacement;
+}
+
+static string modeName(bool bXZ){
+    return bXZ ? "(x, z) (y, z)" : "(x, y) twice";
+}
+
+//--------------------------------------------------------------
+bool Benchmarks::runAll(const KinectFrame& frame, const Settings& settings){
+    if (!frame.rawDepth.isAllocated()){
+        ofLogWarning("Benchmarks") << "no frame to benchmark with yet";
+        return true;
+    }
+    numFailures = 0;
+    depthThreshold(frame, settings);
+    meshers(frame, settings);
+    tiledDelaunay(frame, settings);
+    adaptiveSampling(frame, settings);
+    vertexColors(frame);
+    triangleCulling(frame, settings);
+    triangleCompaction(frame, settings);
+    noiseDisplacement(frame, settings);
+    meshModulation(frame, settings);
+    bakedNoise(frame, settings);
+
+    if (numFailures > 0) ofLogError("Benchmarks") << numFailures << " checks failed";
+    return numFailures == 0;
+}
+
+//--------------------------------------------------------------
+void Benchmarks::depthThreshold(const KinectFrame& frame, const Settings& settings){
+
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+    int count = width * height;
+    const unsigned short* depth = frame.rawDepth.getData();
+
+    vector<unsigned char> reference(count);
+    vector<unsigned char> mask(count);
+
+    // The loop updateDelaunay() used to run, column by column through getDistanceAt()
+    double baseline = timeMicros([&]{
+        for(int x = 0; x < width; x++) {
+            for(int y = 0; y < height; y++) {
+                float distance = frame.getDistanceAt(x, y);
+                int pIndex = x + y * width;
+                reference[pIndex] = 0;
+                if(distance > settings.depthNear && distance < settings.depthFar) {
+                    reference[pIndex] = 255;
+                }
+            }
+        }
+    });
+
+    ofLogNotice("Benchmarks") << "depth threshold, " << width << "x" << height;
+    logResult("column major loop", baseline, baseline);
+
+    timeInstructionSets(DepthKernels::getBestInstructionSet(), baseline, ITERATIONS, [&](DepthKernels::InstructionSet s){
+        DepthKernels::threshold(depth, count, settings.depthNear, settings.depthFar, &mask[0], s);
+    }, [&](DepthKernels::InstructionSet s){
+        if (mask != reference){
+            numFailures++;
+            ofLogError("Benchmarks") << DepthKernels::getName(s) << " threshold doesn't match the reference";
+        }
+        return DepthKernels::getName(s);
+    });
+}
+
+//--------------------------------------------------------------
+void Benchmarks::meshers(const KinectFrame& frame, const Settings& settings){
+
+    vector<unsigned char> mask;
+    thresholdMask(frame, settings, mask);
+
+    ofxDelaunay del;
+    GridMesher grid;
+    vector<ofPoint> points;
+
+    ofLogNotice("Benchmarks") << "meshing, delaunay against the sampling grid";
+    for (int spacing = 1; spacing <= 6; spacing++){
+
+        // The delaunay gets slow quickly at the finer spacings, so it gets
+        // fewer runs
+        double delaunay = timeMicros([&]{
+            triangulate(frame, mask, spacing, settings, points, del);
+        }, 3);
+        int delaunayTriangles = del.triangleMesh.getNumIndices() / 3;
+
+        double gridded = timeMicros([&]{
+            grid.update(frame, &mask[0], spacing, settings.depthNear, settings.depthFar);
+        }, 20);
+
+        // Both cover the same samples, so on a solid subject they should come
+        // out with about the same number of triangles; the delaunay has a few
+        // more, bridging the gaps
+        ofLogNotice("Benchmarks") << "  spacing " << spacing << ", " << points.size() << " points";
+        logResult("delaunay, " + ofToString(delaunayTriangles) + " triangles", delaunay, delaunay);
+        logResult("grid, " + ofToString(grid.getNumTriangles()) + " triangles", gridded, delaunay);
+        if (grid.getNumTriangles() > delaunayTriangles){
+            ofLogWarning("Benchmarks") << "grid mesher made more triangles than the delaunay";
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void Benchmarks::tiledDelaunay(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 3;
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+
+    vector<unsigned char> mask;
+    thresholdMask(frame, settings, mask);
+
+    // The whole image in one go, on this thread
+    ofxDelaunay del;
+    vector<ofPoint> points;
+    double baseline = timeMicros([&]{
+        triangulate(frame, mask, spacing, settings, points, del);
+    }, 5);
+
+    ofLogNotice("Benchmarks") << "tiled delaunay, spacing " << spacing << ", " << points.size() << " points";
+    logResult("whole image", baseline, baseline);
+
+    // Every tile rebuilt every time, on more and more threads
+    vector<uint64_t> triangles;
+    vector<uint64_t> reference;
+    eachThreadPool([&](ThreadPool& pool, int threads){
+        TiledDelaunay tiled;
+        tiled.setThreadPool(&pool);
+
+        double micros = timeMicros([&]{
+            tiled.invalidate();
+            tiled.update(frame, &mask[0], spacing, settings.depthNear, settings.depthFar);
+        }, 5);
+
+        // Which way the whole image above splits a cell on a circle is a
+        // coin toss, so it's checked against the whole image triangulated
+        // from the same nudged samples instead. The tiles and seams should
+        // make exactly its triangles, any crack or overlap along a seam and
+        // they won't.
+        gatherTiledTriangles(tiled, triangles);
+        triangulateWhole(tiled, reference);
+        float referenceArea = tiledCoverage(tiled, reference, mask, width, height);
+        float coverage = referenceArea > 0 ? tiledCoverage(tiled, triangles, mask, width, height) / referenceArea : 1;
+        if (triangles != reference){
+            numFailures++;
+            ofLogError("Benchmarks") << "tiled triangulation on " << threads << " threads doesn't match the whole image's, "
+                                     << triangles.size() << " triangles against " << reference.size() << ", "
+                                     << ofToString(coverage * 100, 2) << "% coverage";
+        }
+        logResult(ofToString(threads) + " threads, " + ofToString(coverage * 100, 1) + "% coverage", micros, baseline);
+    });
+}
+
+//--------------------------------------------------------------
+void Benchmarks::adaptiveSampling(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 3;
+
+    vector<unsigned char> mask;
+    thresholdMask(frame, settings, mask);
+
+    // The uniform grid updateDelaunay() samples by default
+    ofxDelaunay del;
+    vector<ofPoint> points;
+    double baseline = timeMicros([&]{
+        triangulate(frame, mask, spacing, settings, points, del);
+    }, 5);
+    if (points.size() < 3){
+        ofLogWarning("Benchmarks") << "not enough of a subject to sample";
+        return;
+    }
+    int uniformPoints = points.size();
+
+    ofLogNotice("Benchmarks") << "adaptive sampling against a uniform grid at spacing " << spacing;
+    logResult("uniform, " + ofToString(uniformPoints) + " points, "
+              + ofToString(meanDepthError(del.triangleMesh, frame, mask), 2) + " mm mean error", baseline, baseline);
+
+    // The same frame on a half, quarter and eighth of the vertices
+    AdaptiveSampler sampler;
+    for (int fraction = 2; fraction <= 8; fraction *= 2){
+        sampler.setVertexBudget(uniformPoints / fraction);
+        double micros = timeMicros([&]{
+            points.clear();
+            sampler.sample(frame, &mask[0], settings.depthNear, settings.depthFar, points);
+            del.reset();
+            if (points.size() < 3) return;
+            del.addPoints(points);
+            del.triangulate();
+        }, 5);
+        if (points.size() < 3) continue;
+        logResult("adaptive, " + ofToString(points.size()) + " points, "
+                  + ofToString(meanDepthError(del.triangleMesh, frame, mask), 2) + " mm mean error", micros, baseline);
+    }
+}
+
+//--------------------------------------------------------------
+void Benchmarks::vertexColors(const KinectFrame& frame){
+
+    // A vertex every third pixel, about what a mesh at spacing 3 colours
+    const int spacing = 3;
+    const int desatVal = 1;     // What ofApp's 1.9 comes out as
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+
+    vector<int> pixels;
+    for (int y = 0; y < height; y += spacing){
+        for (int x = 0; x < width; x += spacing){
+            pixels.push_back(x + y * width);
+        }
+    }
+    int count = pixels.size();
+
+    // What updateDelaunay() did per vertex, through HSB
+    vector<ofFloatColor> reference(count);
+    double baseline = timeMicros([&]{
+        for (int i = 0; i < count; i++){
+            ofColor c = frame.getColorAt(pixels[i] % width, pixels[i] / width);
+            c.a = 255;
+            c.setSaturation(c.getSaturation() / desatVal);
+            reference[i] = c;
+        }
+    });
+
+    ofLogNotice("Benchmarks") << "vertex colours, " << count << " vertices";
+    logResult("per vertex through HSB", baseline, baseline);
+
+    // At that saturation the mesher leaves out the desaturation altogether,
+    // which should come out within a rounding step of HSB
+    vector<ofFloatColor> colors(count);
+    double micros = timeMicros([&]{
+        ColorKernels::gather(frame.color.getData(), &pixels[0], count, &colors[0].r);
+    });
+    float worst = 0;
+    for (int i = 0; i < count; i++){
+        worst = max(worst, fabs(colors[i].r - reference[i].r));
+        worst = max(worst, fabs(colors[i].g - reference[i].g));
+        worst = max(worst, fabs(colors[i].b - reference[i].b));
+    }
+    if (worst > 1.5 / 255){
+        numFailures++;
+        ofLogError("Benchmarks") << "gathered colours are up to " << ofToString(worst * 255, 1) << " steps off the reference";
+    }
+    logResult("gather as it is", micros, baseline);
+
+    // Below it, every version has to match the luma lerp worked out per
+    // vertex. HSB keeps the brightest channel rather than the luma, so it
+    // isn't the same desaturation and how far off it comes is only logged.
+    vector<unsigned char> rgb(count * 3);
+    vector<ofFloatColor> lerped(count), hsb(count), scalar(count);
+    ColorKernels::gather(frame.color.getData(), &pixels[0], count, &rgb[0]);
+    DepthKernels::InstructionSet best = std::min(DepthKernels::getBestInstructionSet(), DepthKernels::SSE2);
+    const float saturations[] = { 0.5, 0 };
+    for (int n = 0; n < 2; n++){
+        float saturation = saturations[n];
+        double hsbMicros = timeMicros([&]{
+            for (int i = 0; i < count; i++){
+                ofColor c = frame.getColorAt(pixels[i] % width, pixels[i] / width);
+                c.a = 255;
+                c.setSaturation(c.getSaturation() * saturation);
+                hsb[i] = c;
+            }
+        });
+        for (int i = 0; i < count; i++){
+            const unsigned char* p = &rgb[i * 3];
+            double luma = p[0] * 0.299 + p[1] * 0.587 + p[2] * 0.114;
+            lerped[i].set((luma + (p[0] - luma) * saturation) / 255,
+                          (luma + (p[1] - luma) * saturation) / 255,
+                          (luma + (p[2] - luma) * saturation) / 255);
+        }
+        ColorKernels::desaturate(&rgb[0], count, saturation, &scalar[0].r, DepthKernels::SCALAR);
+
+        ofLogNotice("Benchmarks") << "  saturation " << saturation;
+        logResult("per vertex through HSB", hsbMicros, hsbMicros);
+        timeInstructionSets(best, hsbMicros, ITERATIONS, [&](DepthKernels::InstructionSet s){
+            ColorKernels::gather(frame.color.getData(), &pixels[0], count, &rgb[0]);
+            ColorKernels::desaturate(&rgb[0], count, saturation, &colors[0].r, s);
+        }, [&](DepthKernels::InstructionSet s){
+            float worst = 0, offHsb = 0;
+            for (int i = 0; i < count; i++){
+                worst = max(worst, fabs(colors[i].r - lerped[i].r));
+                worst = max(worst, fabs(colors[i].g - lerped[i].g));
+                worst = max(worst, fabs(colors[i].b - lerped[i].b));
+                offHsb += fabs(colors[i].r - hsb[i].r) + fabs(colors[i].g - hsb[i].g) + fabs(colors[i].b - hsb[i].b);
+            }
+            if (worst > 0.01 / 255){
+                numFailures++;
+                ofLogError("Benchmarks") << DepthKernels::getName(s) << " colours are up to "
+                                         << ofToString(worst * 255, 2) << " steps off the luma lerp";
+            }
+
+            // And the kernels should agree with each other exactly
+            if (memcmp(&scalar[0], &colors[0], count * sizeof(ofFloatColor)) != 0){
+                numFailures++;
+                ofLogError("Benchmarks") << DepthKernels::getName(s) << " desaturation doesn't match the scalar kernel";
+            }
+            return "gather + " + DepthKernels::getName(s) + " luma lerp, "
+                   + ofToString(offHsb * 255 / (count * 3), 1) + " steps off HSB on average";
+        });
+    }
+}
+
+//--------------------------------------------------------------
+void Benchmarks::triangleCulling(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 3;
+    const float threshold = 0.5;
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+
+    // Some triangles to cull, with the edges of the subject in them
+    vector<unsigned char> mask;
+    GridMesher grid;
+    if (!meshGrid(frame, settings, spacing, mask, grid)) return;
+    int count = grid.getNumTriangles();
+    vector<ofVec3f> corners;
+    gatherCorners(grid, corners);
+
+    // The single sample at the centroid updateDelaunay() used to take
+    vector<unsigned char> reference(count);
+    double baseline = timeMicros([&]{
+        for (int i = 0; i < count; i++){
+            ofVec3f centre = (corners[i*3] + corners[i*3+1] + corners[i*3+2]) / 3.0;
+            int x = floor(ofClamp(centre.x + width / 2, 0, width - 1));
+            int y = floor(ofClamp(centre.y + height / 2, 0, height - 1));
+            reference[i] = mask[x + y * width] > 0;
+        }
+    });
+    int referenceKept = 0;
+    for (int i = 0; i < count; i++) referenceKept += reference[i];
+
+    ofLogNotice("Benchmarks") << "triangle culling, " << count << " triangles";
+    logResult("centroid sample, kept " + ofToString(referenceKept), baseline, baseline);
+
+    // Bounding box coverage, including building the table
+    MaskCoverage coverage;
+    vector<unsigned char> keep(count);
+    vector<unsigned char> scalar(count);
+    coverage.build(&mask[0], width, height);
+    coverage.cull(&corners[0], count, threshold, &scalar[0], DepthKernels::SCALAR);
+    DepthKernels::InstructionSet best = std::min(DepthKernels::getBestInstructionSet(), DepthKernels::SSE2);
+    timeInstructionSets(best, baseline, ITERATIONS, [&](DepthKernels::InstructionSet s){
+        coverage.build(&mask[0], width, height);
+        coverage.cull(&corners[0], count, threshold, &keep[0], s);
+    }, [&](DepthKernels::InstructionSet s){
+        if (keep != scalar){
+            numFailures++;
+            ofLogError("Benchmarks") << DepthKernels::getName(s) << " culling doesn't match the scalar version";
+        }
+        int kept = 0;
+        for (int i = 0; i < count; i++) kept += keep[i];
+        return DepthKernels::getName(s) + " box coverage, kept " + ofToString(kept);
+    });
+}
+
+//--------------------------------------------------------------
+void Benchmarks::triangleCompaction(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 3;
+    const float threshold = 0.5;
+    int width = frame.getWidth();
+    int height = frame.getHeight();
+
+    // The grid mesher's triangles, queued the way updateDelaunay() queues them
+    vector<unsigned char> mask;
+    GridMesher grid;
+    if (!meshGrid(frame, settings, spacing, mask, grid)) return;
+    const vector<ofVec3f>& verts = grid.getVertices();
+    const vector<int>& ids = grid.getIndices();
+    int count = grid.getNumTriangles();
+    vector<ofVec3f> corners;
+    gatherCorners(grid, corners);
+
+    MaskCoverage coverage;
+    coverage.build(&mask[0], width, height);
+
+    // One triangle at a time
+    TriangleCompactor serial;
+    serial.setup(verts.size(), count);
+    vector<ofVec3f> referenceVertices;
+    vector<int> referencePixels;
+    vector<ofIndexType> referenceIndices;
+    int kept = 0;
+    double baseline = timeMicros([&]{
+        kept = serial.compactSerial(coverage, threshold, &ids[0], &corners[0], count, verts.size(), width, height,
+                                    referenceVertices, referencePixels, referenceIndices);
+    });
+
+    ofLogNotice("Benchmarks") << "triangle compaction, " << count << " triangles, kept " << kept
+                              << " with " << referenceVertices.size() << " vertices";
+    logResult("serial", baseline, baseline);
+
+    // Flags, prefix sums and scatter, on more and more threads. It has to
+    // come out exactly the same every time.
+    eachThreadPool([&](ThreadPool& pool, int threads){
+        TriangleCompactor compactor;
+        compactor.setThreadPool(&pool);
+        compactor.setup(verts.size(), count);
+
+        vector<ofVec3f> vertices;
+        vector<int> pixels;
+        vector<ofIndexType> indices;
+        double micros = timeMicros([&]{
+            compactor.compact(coverage, threshold, &ids[0], &corners[0], count, verts.size(), width, height,
+                              vertices, pixels, indices);
+        });
+        if (vertices != referenceVertices || pixels != referencePixels || indices != referenceIndices){
+            numFailures++;
+            ofLogError("Benchmarks") << "compaction on " << threads << " threads doesn't match the serial version";
+        }
+        logResult(ofToString(threads) + " threads", micros, baseline);
+    });
+}
+
+//--------------------------------------------------------------
+void Benchmarks::noiseDisplacement(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 3;
+    const float t = 0.37;
+
+    // The noise on its own first, each version against ofSignedNoise(). How
+    // close they come is checked by tests/noiseKernels.
+    const int samples = 100000;
+    const float loopZ = settings.noiseRadius * sin(TWO_PI * t);
+    const float loopW = settings.noiseRadius * cos(TWO_PI * t);
+    vector<float> x(samples), y(samples), noise(samples);
+    for (int i = 0; i < samples; i++){
+        x[i] = ofRandom(-10, 10);
+        y[i] = ofRandom(-10, 10);
+    }
+    ofLogNotice("Benchmarks") << "noise displacement";
+    double noiseBaseline = timeMicros([&]{
+        for (int i = 0; i < samples; i++) noise[i] = ofSignedNoise(x[i], y[i], loopZ, loopW);
+    }, 20);
+    logResult(ofToString(samples) + " points, ofSignedNoise()", noiseBaseline, noiseBaseline);
+    timeInstructionSets(DepthKernels::getBestInstructionSet(), noiseBaseline, 20, [&](DepthKernels::InstructionSet s){
+        NoiseKernels::signedNoise(&x[0], &y[0], loopZ, loopW, samples, &noise[0], s);
+    }, [&](DepthKernels::InstructionSet s){
+        return DepthKernels::getName(s) + " batched";
+    });
+
+    // Then displacing a real mesh's worth of vertices, against the loop
+    // modulateDelaunay() used to run
+    vector<unsigned char> mask;
+    GridMesher grid;
+    if (!meshGrid(frame, settings, spacing, mask, grid)) return;
+    const vector<ofVec3f>& rest = grid.getVertices();
+
+    for (int mode = 0; mode < 2; mode++){
+        bool bNoiseMode = mode;
+        vector<ofVec3f> reference = rest;
+        double baseline = timeMicros([&]{
+            reference = rest;
+            for (size_t i = 0; i < reference.size(); i++){
+                ofVec3f& vecMod = reference[i];
+                if (bNoiseMode){
+                    vecMod.x += ofMap(ofSignedNoise(settings.noiseScale * vecMod.x, settings.noiseScale * vecMod.z, settings.noiseRadius * sin(TWO_PI * t), settings.noiseRadius * cos(TWO_PI * t)), -1, 1, -settings.noiseAmt, settings.noiseAmt);
+                    vecMod.y += ofMap(ofSignedNoise(settings.noiseScale * vecMod.y, settings.noiseScale * vecMod.z, settings.noiseRadius * sin(TWO_PI * t), settings.noiseRadius * cos(TWO_PI * t)), -1, 1, -settings.noiseAmt, settings.noiseAmt);
+                }
+                else {
+                    vecMod.x += ofMap(ofSignedNoise(settings.noiseScale * vecMod.x, settings.noiseScale * vecMod.y, settings.noiseRadius * sin(TWO_PI * t), settings.noiseRadius * cos(TWO_PI * t)), -1, 1, -settings.noiseAmt, settings.noiseAmt);
+                    vecMod.y += ofMap(ofSignedNoise(settings.noiseScale * vecMod.x, settings.noiseScale * vecMod.y, settings.noiseRadius * sin(TWO_PI * t), settings.noiseRadius * cos(TWO_PI * t)), -1, 1, -settings.noiseAmt, settings.noiseAmt);
+                }
+            }
+        }, 20);
+        logResult(modeName(bNoiseMode) + ", " + ofToString(rest.size()) + " vertices, per vertex", baseline, baseline);
+
+        NoiseKernels::Displacement displacement = displacementAt(settings, t, bNoiseMode);
+        vector<ofVec3f> displaced;
+        timeInstructionSets(DepthKernels::getBestInstructionSet(), baseline, 20, [&](DepthKernels::InstructionSet s){
+            displaced = rest;
+            NoiseKernels::displace(&displaced[0].x, displaced.size(), displacement, s);
+        }, [&](DepthKernels::InstructionSet s){
+            return DepthKernels::getName(s) + " batched";
+        });
+    }
+}
+
+//--------------------------------------------------------------
+void Benchmarks::meshModulation(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 1;
+    const int minVertices = 100000;
+    const float t = 0.37;
+
+    // Every masked pixel of the frame, repeated until there's as many
+    // vertices as a dense mesh
+    vector<unsigned char> mask;
+    thresholdMask(frame, settings, mask);
+    vector<ofPoint> points;
+    samplePoints(frame, mask, spacing, settings, points);
+    if (points.empty()){
+        ofLogWarning("Benchmarks") << "no vertices to modulate";
+        return;
+    }
+    vector<ofVec3f> rest;
+    while ((int)rest.size() < minVertices) rest.insert(rest.end(), points.begin(), points.end());
+
+    ofLogNotice("Benchmarks") << "mesh modulation, " << rest.size() << " vertices";
+    for (int mode = 0; mode < 2; mode++){
+        NoiseKernels::Displacement displacement = displacementAt(settings, t, mode);
+
+        // On the calling thread, as the reference
+        MeshModulator serial;
+        vector<ofVec3f> reference(rest.size());
+        double baseline = timeMicros([&]{
+            serial.modulate(&rest[0], &reference[0], rest.size(), displacement);
+        }, 20);
+        logResult(modeName(mode) + ", serial", baseline, baseline);
+
+        // Then chunked across more and more threads, which has to displace
+        // every vertex exactly the same
+        eachThreadPool([&](ThreadPool& pool, int threads){
+            MeshModulator modulator;
+            modulator.setThreadPool(&pool);
+
+            vector<ofVec3f> displaced(rest.size());
+            double micros = timeMicros([&]{
+                modulator.modulate(&rest[0], &displaced[0], rest.size(), displacement);
+            }, 20);
+            if (displaced != reference){
+                numFailures++;
+                ofLogError("Benchmarks") << "modulation on " << threads << " threads doesn't match the serial version";
+            }
+            logResult(ofToString(threads) + " threads", micros, baseline);
+        });
+    }
+}
+
+//--------------------------------------------------------------
+void Benchmarks::bakedNoise(const KinectFrame& frame, const Settings& settings){
+
+    const int spacing = 3;
+
+    vector<unsigned char> mask;
+    GridMesher grid;
+    if (!meshGrid(frame, settings, spacing, mask, grid)) return;
+    const vector<ofVec3f>& rest = grid.getVertices();
+
+    ofLogNotice("Benchmarks") << "baked noise, " << rest.size() << " vertices";
+    for (int mode = 0; mode < 2; mode++){
+        NoiseVolume::Key key;
+        key.scale = settings.noiseScale;
+        key.radius = settings.noiseRadius;
+        key.bXZ = mode;
+        key.width = frame.getWidth();
+        key.height = frame.getHeight();
+        key.depthFar = settings.depthFar;
+        key.amount = settings.noiseAmt;
+        if (!NoiseVolume::isBakeable(key)){
+            ofLogWarning("Benchmarks") << "noise too fine to bake at scale " << key.scale;
+            return;
+        }
+
+        NoiseVolume volume;
+        uint64_t start = ofGetElapsedTimeMicros();
+        volume.build(key);
+        ofLogNotice("Benchmarks") << "    " << modeName(mode) << ", baked "
+                                  << volume.getNumSamples() << " samples in "
+                                  << ofToString((ofGetElapsedTimeMicros() - start) / 1000.0, 1) << " ms";
+
+        // Round the loop against the noise worked out directly. It's an
+        // interpolation, so it's only ever close.
+        MeshModulator modulator;
+        vector<ofVec3f> direct(rest.size()), baked(rest.size());
+        double baseline = 0, micros = 0;
+        float worst = 0, mean = 0;
+        const int phases = 8;
+        for (int i = 0; i < phases; i++){
+            float t = (i + 0.5) / phases;
+            NoiseKernels::Displacement displacement = displacementAt(settings, t, mode);
+
+            baseline += timeMicros([&]{
+                modulator.modulate(&rest[0], &direct[0], rest.size(), displacement);
+            }, 20);
+            micros += timeMicros([&]{
+                modulator.modulate(&rest[0], &baked[0], rest.size(), displacement, &volume, t);
+            }, 20);
+            for (size_t j = 0; j < rest.size(); j++){
+                float error = baked[j].distance(direct[j]);
+                worst = max(worst, error);
+                mean += error;
+            }
+        }
+        mean /= phases * rest.size();
+        logResult("direct", baseline / phases, baseline / phases);
+        logResult("baked, " + ofToString(mean, 3) + " mean and " + ofToString(worst, 3) + " worst off direct",
+                  micros / phases, baseline / phases);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ofMain.h"
+#include "KinectFrame.h"
+
+// Microbenchmarks of the pipeline's kernels against the code they replaced,
+// run on a real frame. Each one checks the results match before timing them
+// and logs what it finds. Press 'm' in debug mode, or they run at the end of
+// a headless replay, which fails if any check does.
+
+namespace Benchmarks {
+
+    struct Settings {
+        int depthNear;
+        int depthFar;
+        float noiseScale;
+        float noiseRadius;
+        float noiseAmt;
+    };
+
+    bool runAll(const KinectFrame& frame, const Settings& settings);   // False if any check failed
+
+    void depthThreshold(const KinectFrame& frame, const Settings& settings);
+    void meshers(const KinectFrame& frame, const Settings& settings);
+    void tiledDelaunay(const KinectFrame& frame, const Settings& settings);
+    void adaptiveSampling(const KinectFrame& frame, const Settings& settings);
+    void vertexColors(const KinectFrame& frame);
+    void triangleCulling(const KinectFrame& frame, const Settings& settings);
+    void triangleCompaction(const KinectFrame& frame, const Settings& settings);
+    void noiseDisplacement(const KinectFrame& frame, const Settings& settings);
+    void meshModulation(const KinectFrame& frame, const Settings& settings);
+    void bakedNoise(const KinectFrame& frame, const Settings& settings);
+}
@@ -0,0 +1,144 @@
+#include "CaptureThread.h"
+
+//--------------------------------------------------------------
+CaptureThread::CaptureThread()
+: bThreaded(true), bFrameNew(false), bNewestFresh(false), numCaptured(0), numDropped(0){
+    for (int i = 0; i < NUM_FRAMES; i++) frames[i] = make_shared<KinectFrame>();
+    current = frames[0];    // Empty until the first frame comes in
+}
+
+//--------------------------------------------------------------
+CaptureThread::~CaptureThread(){
+    stop();
+}
+
+//--------------------------------------------------------------
+void CaptureThread::setup(shared_ptr<KinectSource> source, bool threaded){
+    stop();
+    this->source = source;
+    bThreaded = threaded;
+}
+
+//--------------------------------------------------------------
+void CaptureThread::start(){
+    if (bThreaded && !isThreadRunning()) startThread();
+}
+
+//--------------------------------------------------------------
+void CaptureThread::stop(){
+    if (isThreadRunning()) waitForThread(true);
+}
+
+//--------------------------------------------------------------
+void CaptureThread::update(){
+    if (!bThreaded) capture();
+
+    std::unique_lock<std::mutex> lock(publishMutex);
+    bFrameNew = bNewestFresh;
+    if (bNewestFresh){
+        current = newest;
+        bNewestFresh = false;
+    }
+}
+
+//--------------------------------------------------------------
+bool CaptureThread::isFrameNew() const {
+    return bFrameNew;
+}
+
+//--------------------------------------------------------------
+const KinectFrame& CaptureThread::getFrame() const {
+    return *current;
+}
+
+//--------------------------------------------------------------
+shared_ptr<const KinectFrame> CaptureThread::shareFrame() const {
+    return current;
+}
+
+//--------------------------------------------------------------
+bool CaptureThread::open(){
+    bool bWasRunning = isThreadRunning();
+    stop();
+    bool bOpened = source->open();
+    if (bWasRunning) start();
+    return bOpened;
+}
+
+//--------------------------------------------------------------
+void CaptureThread::close(){
+    bool bWasRunning = isThreadRunning();
+    stop();
+    source->close();
+    if (bWasRunning) start();
+}
+
+//--------------------------------------------------------------
+int CaptureThread::getNumCaptured() const {
+    return numCaptured;
+}
+
+//--------------------------------------------------------------
+int CaptureThread::getNumDropped() const {
+    return numDropped;
+}
+
+//--------------------------------------------------------------
+void CaptureThread::threadedFunction(){
+    while (isThreadRunning()){
+        // Nothing new yet, don't spin a core waiting for the sensor
+        if (!capture()) sleep(1);
+    }
+}
+
+//--------------------------------------------------------------
+bool CaptureThread::capture(){
+
+    source->update();
+    if (!source->isFrameNew()) return false;
+
+    shared_ptr<KinectFrame> frame = getFreeFrame();
+    if (frame == NULL){
+        numDropped++;   // Can't happen while every holder keeps to one frame
+        return true;
+    }
+
+    // Trade buffers with the source rather than copying them. It fills
+    // whatever it's holding from scratch on its next frame, so it only needs
+    // them to be the right size.
+    int width = source->getWidth();
+    int height = source->getHeight();
+    if (frame->rawDepth.getWidth() != width || frame->rawDepth.getHeight() != height){
+        frame->rawDepth.allocate(width, height, 1);
+        frame->depth.allocate(width, height, 1);
+        frame->color.allocate(width, height, 3);
+    }
+    frame->rawDepth.swap(source->getRawDepthPixels());
+    frame->depth.swap(source->getDepthPixels());
+    frame->color.swap(source->getPixels());
+    frame->index = numCaptured;
+
+    {
+        std::unique_lock<std::mutex> lock(publishMutex);
+        if (bNewestFresh) numDropped++;
+        newest = frame;
+        bNewestFresh = true;
+    }
+    numCaptured++;
+    return true;
+}
+
+//--------------------------------------------------------------
+shared_ptr<KinectFrame> CaptureThread::getFreeFrame(){
+
+    // A frame only the pool holds can't be reached by anyone else, and
+    // nobody can take another hold on it without one already
+    for (int i = 0; i < NUM_FRAMES; i++){
+        if (frames[i].use_count() == 1){
+            // Make sure whoever let go last was done reading it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return frames[i];
+        }
+    }
+    return NULL;
+}
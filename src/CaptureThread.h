@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "KinectSource.h"
+#include "KinectFrame.h"
+
+// Pulls frames from a KinectSource on its own thread and hands the newest
+// complete one to the render loop, so a slow or stalled sensor never holds up
+// a frame.
+//
+// Nothing is copied on the way. Frames come from a small pool, and the
+// source's pixel buffers are swapped with the frame's rather than copied into
+// it. The mesher and the face tracker hold on to the frame they were handed
+// through a shared pointer, and the capture thread only ever refills a frame
+// nobody else is holding.
+//
+// It can also run synchronously, pulling a frame inline on every update(),
+// which is what a deterministic replay wants.
+
+class CaptureThread : public ofThread {
+
+    public:
+        CaptureThread();
+        ~CaptureThread();
+
+        void setup(shared_ptr<KinectSource> source, bool threaded = true);
+        void start();
+        void stop();
+
+        void update();          // Call once per frame from the render loop
+        bool isFrameNew() const;
+        // The newest frame. It stays put until the next update(), so it can be
+        // read, or wrapped by cv::Mats and textures, in place until then.
+        // It may be shared, so it's never written to.
+        const KinectFrame& getFrame() const;
+
+        // The same frame, kept from being refilled for as long as the pointer
+        // is held, from any thread
+        shared_ptr<const KinectFrame> shareFrame() const;
+
+        // Reopen or close the source, safely pausing capture around it
+        bool open();
+        void close();
+
+        int getNumCaptured() const;
+        int getNumDropped() const;  // Captured but replaced before the render loop saw them
+
+    private:
+        void threadedFunction();
+        bool capture();
+        shared_ptr<KinectFrame> getFreeFrame();
+
+        // The render loop's, the mesher's, the tracker's, the newest and the
+        // one being filled can all be different frames, so one is always free
+        static const int NUM_FRAMES = 5;
+
+        shared_ptr<KinectSource> source;
+        bool bThreaded;
+        bool bFrameNew;
+
+        shared_ptr<KinectFrame> frames[NUM_FRAMES];
+        shared_ptr<KinectFrame> current;    // The render loop's, only touched by it
+        shared_ptr<KinectFrame> newest;     // Last one published
+        bool bNewestFresh;                  // And the render loop hasn't taken it yet
+        std::mutex publishMutex;            // Guards newest, held just long enough to swap a pointer
+        std::atomic<int> numCaptured;
+        std::atomic<int> numDropped;
+};
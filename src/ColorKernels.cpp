@@ -0,0 +1,95 @@
+#include "ColorKernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    // Rec. 601 luma weights
+    const float LUMA_R = 0.299f;
+    const float LUMA_G = 0.587f;
+    const float LUMA_B = 0.114f;
+    const float TO_UNIT = 1.0f / 255.0f;
+
+    void desaturateScalar(const unsigned char* rgb, int count, float saturation, float* rgba){
+        for (int i = 0; i < count; i++){
+            float r = rgb[i * 3];
+            float g = rgb[i * 3 + 1];
+            float b = rgb[i * 3 + 2];
+            float luma = r * LUMA_R + g * LUMA_G + b * LUMA_B;
+            rgba[i * 4] = (luma + (r - luma) * saturation) * TO_UNIT;
+            rgba[i * 4 + 1] = (luma + (g - luma) * saturation) * TO_UNIT;
+            rgba[i * 4 + 2] = (luma + (b - luma) * saturation) * TO_UNIT;
+            rgba[i * 4 + 3] = 1;
+        }
+    }
+
+#if defined(__SSE2__)
+    // Four colours at a time, a channel to a register, then transposed back
+    // to RGBA on the way out
+    int desaturateSSE2(const unsigned char* rgb, int count, float saturation, float* rgba){
+        const __m128 lumaR = _mm_set1_ps(LUMA_R);
+        const __m128 lumaG = _mm_set1_ps(LUMA_G);
+        const __m128 lumaB = _mm_set1_ps(LUMA_B);
+        const __m128 sat = _mm_set1_ps(saturation);
+        const __m128 toUnit = _mm_set1_ps(TO_UNIT);
+
+        int i = 0;
+        for (; i + 4 <= count; i += 4){
+            const unsigned char* p = rgb + i * 3;
+            __m128 r = _mm_setr_ps(p[0], p[3], p[6], p[9]);
+            __m128 g = _mm_setr_ps(p[1], p[4], p[7], p[10]);
+            __m128 b = _mm_setr_ps(p[2], p[5], p[8], p[11]);
+
+            __m128 luma = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, lumaR), _mm_mul_ps(g, lumaG)), _mm_mul_ps(b, lumaB));
+            r = _mm_mul_ps(_mm_add_ps(luma, _mm_mul_ps(_mm_sub_ps(r, luma), sat)), toUnit);
+            g = _mm_mul_ps(_mm_add_ps(luma, _mm_mul_ps(_mm_sub_ps(g, luma), sat)), toUnit);
+            b = _mm_mul_ps(_mm_add_ps(luma, _mm_mul_ps(_mm_sub_ps(b, luma), sat)), toUnit);
+            __m128 a = _mm_set1_ps(1);
+
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+            _mm_storeu_ps(rgba + i * 4, r);
+            _mm_storeu_ps(rgba + i * 4 + 4, g);
+            _mm_storeu_ps(rgba + i * 4 + 8, b);
+            _mm_storeu_ps(rgba + i * 4 + 12, a);
+        }
+        return i;
+    }
+#endif
+}
+
+//--------------------------------------------------------------
+void ColorKernels::gather(const unsigned char* rgb, const int* pixels, int count, unsigned char* out){
+    for (int i = 0; i < count; i++){
+        const unsigned char* p = rgb + pixels[i] * 3;
+        out[i * 3] = p[0];
+        out[i * 3 + 1] = p[1];
+        out[i * 3 + 2] = p[2];
+    }
+}
+
+//--------------------------------------------------------------
+void ColorKernels::gather(const unsigned char* rgb, const int* pixels, int count, float* rgba){
+    for (int i = 0; i < count; i++){
+        const unsigned char* p = rgb + pixels[i] * 3;
+        rgba[i * 4] = p[0] * TO_UNIT;
+        rgba[i * 4 + 1] = p[1] * TO_UNIT;
+        rgba[i * 4 + 2] = p[2] * TO_UNIT;
+        rgba[i * 4 + 3] = 1;
+    }
+}
+
+//--------------------------------------------------------------
+void ColorKernels::desaturate(const unsigned char* rgb, int count, float saturation, float* rgba){
+    desaturate(rgb, count, saturation, rgba, DepthKernels::getBestInstructionSet());
+}
+
+//--------------------------------------------------------------
+void ColorKernels::desaturate(const unsigned char* rgb, int count, float saturation, float* rgba, InstructionSet set){
+    int done = 0;
+#if defined(__SSE2__)
+    if (set >= DepthKernels::SSE2) done = desaturateSSE2(rgb, count, saturation, rgba);
+#endif
+    desaturateScalar(rgb + done * 3, count - done, saturation, rgba + done * 4);
+}
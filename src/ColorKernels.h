@@ -0,0 +1,24 @@
+#pragma once
+
+#include "DepthKernels.h"
+
+// Per-vertex colour kernels over the kinect's packed 8 bit RGB image. Like
+// the depth kernels, there's a scalar version and an SSE2 one picked at
+// runtime.
+
+namespace ColorKernels {
+
+    using DepthKernels::InstructionSet;
+
+    // out[i] = the RGB triple at pixel index pixels[i]
+    void gather(const unsigned char* rgb, const int* pixels, int count, unsigned char* out);
+
+    // The same, written as normalised float RGBA, alpha 1. What gathering
+    // then desaturating at 1 comes to, in one pass.
+    void gather(const unsigned char* rgb, const int* pixels, int count, float* rgba);
+
+    // Scales each colour's distance from its own luma by `saturation`, and
+    // writes it as normalised float RGBA, alpha 1, ready for ofFloatColor
+    void desaturate(const unsigned char* rgb, int count, float saturation, float* rgba);
+    void desaturate(const unsigned char* rgb, int count, float saturation, float* rgba, InstructionSet set);
+}
@@ -0,0 +1,279 @@
+#include "DelaunayMesher.h"
+#include "DepthKernels.h"
+#include "ColorKernels.h"
+
+static const int WARMUP_BUILDS = 3;     // One for each of the MeshingThread's output buffers
+
+//--------------------------------------------------------------
+DelaunayMesher::DelaunayMesher()
+:width(0)
+,height(0)
+,numIds(0)
+,settledBuilds(0)
+,allocatingBuilds(0){
+}
+
+//--------------------------------------------------------------
+void DelaunayMesher::setThreadPool(ThreadPool* pool){
+    tiledDelaunay.setThreadPool(pool);
+    compactor.setThreadPool(pool);
+}
+
+//--------------------------------------------------------------
+void DelaunayMesher::build(const KinectFrame& frame, const MeshSettings& settings, MeshOutput& out){
+    
+    bench.begin("updateDelaunay");
+    
+    // Scratch buffers live in the arena and keep their capacity between
+    // builds, so none of this touches the heap.
+    if (frame.getWidth() != width || frame.getHeight() != height){
+        width = frame.getWidth();
+        height = frame.getHeight();
+        arena.setup(width, height);
+        compactor.setup(width * height, width * height * 2);
+        settledBuilds = 0;
+    }
+    
+    // The output meshes take turns, so each one is sized for the worst case,
+    // a vertex on every pixel, the first time it comes round
+    size_t maxVertices = width * height;
+    if (out.rest.capacity() < maxVertices){
+        out.rest.reserve(maxVertices);
+        out.mesh.getVertices().reserve(maxVertices);
+        out.mesh.getColors().reserve(maxVertices);
+        out.mesh.getIndices().reserve(maxVertices * 6);
+    }
+    if (out.mask.getWidth() != width || out.mask.getHeight() != height){
+        out.mask.allocate(width, height, 1);
+    }
+    unsigned char* pix = out.mask.getData();
+    out.frameIndex = frame.index;
+    
+    // Mark every pixel within the depth threshold white, in one row major
+    // pass over the raw depth buffer
+    DepthKernels::threshold(frame.rawDepth.getData(), width * height,
+                            settings.depthNear, settings.depthFar, pix);
+    
+    // Clear the mesh. It's indexed, each triangulated vertex goes in once
+    // however many triangles share it.
+    ofMesh& mesh = out.mesh;
+    mesh.clear();
+    mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    arena.colorPixels.clear();
+    arena.triangleIds.clear();
+    arena.corners.clear();
+    
+    // Either mesh straight off the sampling grid...
+    if (settings.bGridMesher){
+        tiledDelaunay.invalidate();
+        
+        bench.begin("triangulate");
+        gridMesher.update(frame, pix, settings.spacing, settings.depthNear, settings.depthFar);
+        bench.end("triangulate");
+        
+        const vector<ofVec3f>& verts = gridMesher.getVertices();
+        const vector<int>& indices = gridMesher.getIndices();
+        numIds = verts.size();
+        for (size_t i = 0; i + 2 < indices.size(); i += 3){
+            addTriangle(indices[i], verts[indices[i]], indices[i+1], verts[indices[i+1]],
+                        indices[i+2], verts[indices[i+2]]);
+        }
+    }
+    
+    // ...or triangulate it in tiles across every core. Incrementally, only
+    // the tiles that moved are re-triangulated, otherwise all of them.
+    else if (settings.bTiledDelaunay && !settings.bAdaptiveSampling){
+        if (!settings.bIncremental) tiledDelaunay.invalidate();
+        
+        bench.begin("triangulate");
+        tiledDelaunay.update(frame, pix, settings.spacing, settings.depthNear, settings.depthFar);
+        bench.end("triangulate");
+        
+        // Tiles share the samples along their edges, and the seams between
+        // them are made of the same samples, so they all share vertices
+        numIds = tiledDelaunay.getNumSamples();
+        const vector<TiledDelaunay::Tile>& tiles = tiledDelaunay.getTiles();
+        for (size_t t = 0; t < tiles.size(); t++){
+            const TiledDelaunay::Tile& tile = tiles[t];
+            for (size_t i = 0; i + 2 < tile.indices.size(); i += 3){
+                int sample1 = tile.samples[tile.indices[i]];
+                int sample2 = tile.samples[tile.indices[i+1]];
+                int sample3 = tile.samples[tile.indices[i+2]];
+                addTriangle(sample1, tiledDelaunay.getSample(sample1),
+                            sample2, tiledDelaunay.getSample(sample2),
+                            sample3, tiledDelaunay.getSample(sample3));
+            }
+        }
+        const vector<int>& seams = tiledDelaunay.getSeamIndices();
+        for (size_t i = 0; i + 2 < seams.size(); i += 3){
+            addTriangle(seams[i], tiledDelaunay.getSample(seams[i]),
+                        seams[i+1], tiledDelaunay.getSample(seams[i+1]),
+                        seams[i+2], tiledDelaunay.getSample(seams[i+2]));
+        }
+    }
+    else {
+        
+        // ...or in one piece on this thread. The tiles will need building
+        // again when we go back to them.
+        tiledDelaunay.invalidate();
+        
+        del.reset();
+        arena.points.clear();
+        
+        int numPoints = 0;
+        
+        // Spend the points where the detail is...
+        if (settings.bAdaptiveSampling){
+            adaptiveSampler.setVertexBudget(settings.vertexBudget);
+            adaptiveSampler.sample(frame, pix, settings.depthNear, settings.depthFar, arena.points);
+            numPoints = arena.points.size();
+        }
+        
+        // ...or loop through the whole kinect image
+        else {
+            for(int x = 0; x < width; x += settings.spacing) {
+                for(int y = 0; y < height; y += settings.spacing) {
+                    int pIndex = x + width * y;
+                    
+                    // If there is a pixel at the index
+                    if(pix[pIndex] > 0) {
+                        
+                        // Create a temp vector at that pixel, centred on the depth
+                        // image and pushed back by its depth. Only the depth is
+                        // needed, so there's nothing to unproject.
+                        ofVec3f wc(x - width / 2.0, y - height / 2.0, frame.getDistanceAt(x, y));
+                        
+                        // If it's within the threshold...
+                        if(abs(wc.z) > settings.depthNear && abs(wc.z) < settings.depthFar) {
+                            
+                            // flip the Z axis
+                            wc.z = -wc.z;
+                            // And queue the point up for the delaunay
+                            arena.points.push_back(wc);
+                        }
+                        numPoints++;
+                    }
+                }
+            }
+        }
+        
+        // If we have more than 0 points, triangulate. ofxDelaunay allocates its
+        // own working space on every call, so it's timed on its own to keep its
+        // allocations apart from ours.
+        bench.begin("triangulate");
+        if(numPoints > 0) {
+            del.addPoints(arena.points);
+            del.triangulate();
+        }
+        bench.end("triangulate");
+        
+        numIds = del.triangleMesh.getNumVertices();
+        int numTriangles = del.triangleMesh.getNumIndices() / 3;
+        for(int i=0;i<numTriangles;i+=1) {
+            
+            // Create indices and points from the triangulated mesh
+            
+            int indx1 = del.triangleMesh.getIndex(i*3);
+            int indx2 = del.triangleMesh.getIndex(i*3+1);
+            int indx3 = del.triangleMesh.getIndex(i*3+2);
+            addTriangle(indx1, del.triangleMesh.getVertex(indx1),
+                        indx2, del.triangleMesh.getVertex(indx2),
+                        indx3, del.triangleMesh.getVertex(indx3));
+        }
+    }
+    
+    cullTriangles(pix, settings.coverageThreshold, mesh);
+    colorMesh(frame, settings.saturation, mesh);
+    
+    // Keep the undisplaced positions, the buffer keeps its capacity
+    out.rest.assign(mesh.getVertices().begin(), mesh.getVertices().end());
+    
+    bench.end("updateDelaunay");
+    
+    checkAllocations(settings);
+}
+
+//--------------------------------------------------------------
+void DelaunayMesher::checkAllocations(const MeshSettings& settings){
+    
+    // Changing how we sample resizes the samplers' buffers, so give them a
+    // few builds to settle
+    if (settings.spacing == lastSettings.spacing && settings.vertexBudget == lastSettings.vertexBudget
+        && settings.bGridMesher == lastSettings.bGridMesher && settings.bTiledDelaunay == lastSettings.bTiledDelaunay
+        && settings.bAdaptiveSampling == lastSettings.bAdaptiveSampling){
+        settledBuilds = min(settledBuilds + 1, WARMUP_BUILDS + 1);
+    }
+    else {
+        settledBuilds = 0;
+    }
+    lastSettings = settings;
+    if (settledBuilds <= WARMUP_BUILDS) return;
+    
+    // After that, nothing of ours touches the heap. ofxDelaunay allocates its
+    // own working space on every call and there's no handing it ours, so
+    // outside the grid mesher its "triangulate" stage is let off.
+    uint64_t allocations = bench.getLastAllocations("updateDelaunay");
+    if (!settings.bGridMesher) allocations -= bench.getLastAllocations("triangulate");
+    if (allocations > 0) allocatingBuilds++;
+}
+
+//--------------------------------------------------------------
+int DelaunayMesher::getAllocatingBuilds() const {
+    return allocatingBuilds;
+}
+
+//--------------------------------------------------------------
+void DelaunayMesher::addTriangle(int id1, const ofVec3f& p1, int id2, const ofVec3f& p2, int id3, const ofVec3f& p3){
+    
+    // Queued up for culling, see cullTriangles()
+    arena.triangleIds.push_back(id1);
+    arena.triangleIds.push_back(id2);
+    arena.triangleIds.push_back(id3);
+    arena.corners.push_back(p1);
+    arena.corners.push_back(p2);
+    arena.corners.push_back(p3);
+}
+
+//--------------------------------------------------------------
+void DelaunayMesher::cullTriangles(const unsigned char* mask, float threshold, ofMesh& mesh){
+    
+    bench.begin("cull");
+    
+    // Only keep triangles that sit on the subject, not the ones bridging
+    // the gaps around it. Each is judged by how much of its bounding box is
+    // on the depth mask. What's kept goes into the mesh across every core,
+    // in the same order as it would one triangle at a time.
+    int count = arena.triangleIds.size() / 3;
+    coverage.build(mask, width, height);
+    if (count > 0){
+        compactor.compact(coverage, threshold, &arena.triangleIds[0], &arena.corners[0], count, numIds,
+                          width, height, mesh.getVertices(), arena.colorPixels, mesh.getIndices());
+    }
+    
+    bench.end("cull");
+}
+
+//--------------------------------------------------------------
+void DelaunayMesher::colorMesh(const KinectFrame& frame, float saturation, ofMesh& mesh){
+    
+    bench.begin("color");
+    
+    int count = arena.colorPixels.size();
+    vector<ofFloatColor>& colors = mesh.getColors();
+    colors.resize(count);
+    
+    // At full saturation, which is what the piece runs at, the colours go
+    // from the kinect image straight into the mesh's colour buffer...
+    if (count > 0 && saturation == 1){
+        ColorKernels::gather(frame.color.getData(), &arena.colorPixels[0], count, &colors[0].r);
+    }
+    
+    // ...otherwise they're pulled out and desaturated on the way
+    else if (count > 0){
+        arena.rgb.resize(count * 3);
+        ColorKernels::gather(frame.color.getData(), &arena.colorPixels[0], count, &arena.rgb[0]);
+        ColorKernels::desaturate(&arena.rgb[0], count, saturation, &colors[0].r);
+    }
+    
+    bench.end("color");
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxDelaunay.h"
+#include "KinectFrame.h"
+#include "MeshArena.h"
+#include "MaskCoverage.h"
+#include "TriangleCompactor.h"
+#include "TiledDelaunay.h"
+#include "GridMesher.h"
+#include "AdaptiveSampler.h"
+#include "PipelineBench.h"
+#include "ThreadPool.h"
+
+// How to mesh a frame. The render loop fills one of these in from its own
+// settings and hands it over with the frame.
+struct MeshSettings {
+    int spacing = 3;
+    float depthNear = 5;
+    float depthFar = 1000;
+    bool bGridMesher = false;       // Mesh the sampling grid directly, no delaunay
+    bool bTiledDelaunay = true;     // Triangulate in tiles on the thread pool, rather than in one piece
+    bool bAdaptiveSampling = false; // Quadtree sampling rather than every `spacing` pixels
+    bool bIncremental = true;       // Keep the tiles that didn't move since the last build
+    int vertexBudget = 6000;        // For the adaptive sampler
+    float coverageThreshold = 0.5;  // Fraction of a triangle's bounding box that has to be on the mask
+    float saturation = 1;
+};
+
+// Everything one build produces
+struct MeshOutput {
+    ofVboMesh mesh;                 // Indexed triangles, coloured from the RGB image. Only
+                                    // uploaded when it's drawn, so it can be built off the GL thread.
+    vector<ofVec3f> rest;           // The mesh's vertices as built. The mesh's own get displaced
+                                    // from these every frame.
+    ofPixels mask;                  // Pixels within the depth threshold
+    int frameIndex = -1;            // The KinectFrame it was built from
+};
+
+// Turns a kinect frame into the coloured, indexed delaunay mesh: thresholds
+// the depth, samples and triangulates it one of several ways, culls what
+// isn't on the subject and colours the rest. Keeps its scratch buffers, and
+// the tiles it didn't need to rebuild, from one build to the next, so it's
+// meant to be used from one thread at a time.
+
+class DelaunayMesher {
+
+    public:
+        DelaunayMesher();
+
+        void setThreadPool(ThreadPool* pool);
+
+        void build(const KinectFrame& frame, const MeshSettings& settings, MeshOutput& out);
+
+        PipelineBench& getBench() { return bench; }
+
+        // Builds that touched the heap once they'd settled, which shouldn't
+        // happen. Only counted with CAPGRAS_ALLOCATION_COUNTER.
+        int getAllocatingBuilds() const;
+
+    private:
+        void addTriangle(int id1, const ofVec3f& p1, int id2, const ofVec3f& p2, int id3, const ofVec3f& p3);
+        void cullTriangles(const unsigned char* mask, float threshold, ofMesh& mesh);
+        void colorMesh(const KinectFrame& frame, float saturation, ofMesh& mesh);
+        void checkAllocations(const MeshSettings& settings);
+
+        MeshArena arena;
+        MaskCoverage coverage;
+        TriangleCompactor compactor;
+        ofxDelaunay del;
+        TiledDelaunay tiledDelaunay;    // Parallel, and when incremental only re-triangulates what moved
+        GridMesher gridMesher;          // Linear time alternative to both
+        AdaptiveSampler adaptiveSampler; // Fewer, better placed points for the whole image delaunay
+        int width;
+        int height;
+        int numIds;                     // Vertex ids the triangles are queued with run from 0 to this
+
+        MeshSettings lastSettings;
+        int settledBuilds;              // In a row with the same sampling and frame size
+        int allocatingBuilds;
+
+        PipelineBench bench;
+};
@@ -0,0 +1,125 @@
+#include "DensityController.h"
+
+static const float SMOOTHING = 0.1;         // Weight of each new frame in the running cost
+static const float TOLERANCE = 0.15;        // How far over target still counts as on target
+static const int SUSTAIN_FRAMES = 15;       // Frames outside the target before we act
+static const int COOLDOWN_FRAMES = 45;      // Frames to let a change settle
+static const float BUDGET_STEP = 1.25;      // Vertex budget scale per step
+
+//--------------------------------------------------------------
+DensityController::DensityController()
+:targetMillis(33.3)
+,smoothedMillis(33.3)
+,spacing(3)
+,minSpacing(1)
+,maxSpacing(8)
+,vertexBudget(6000)
+,minBudget(1000)
+,maxBudget(20000)
+,framesOver(0)
+,framesUnder(0)
+,cooldown(0){
+}
+
+//--------------------------------------------------------------
+void DensityController::setup(float targetMillis, int spacing, int minSpacing, int maxSpacing,
+                              int vertexBudget, int minBudget, int maxBudget){
+    this->targetMillis = targetMillis;
+    this->spacing = spacing;
+    this->minSpacing = minSpacing;
+    this->maxSpacing = maxSpacing;
+    this->vertexBudget = vertexBudget;
+    this->minBudget = minBudget;
+    this->maxBudget = maxBudget;
+
+    smoothedMillis = targetMillis;
+    framesOver = 0;
+    framesUnder = 0;
+    cooldown = 0;
+}
+
+//--------------------------------------------------------------
+bool DensityController::update(float frameMillis, Knob knob){
+
+    smoothedMillis += (frameMillis - smoothedMillis) * SMOOTHING;
+
+    if (cooldown > 0){
+        cooldown--;
+        return false;
+    }
+
+    // Cost goes with the number of samples, so one step finer multiplies it
+    // by about (spacing / (spacing - 1))^2 on the grid, or by the budget step.
+    // Only refine if that still fits, otherwise we'd bounce straight back.
+    float finer;
+    if (knob == SPACING){
+        float ratio = spacing > 1 ? (float)spacing / (spacing - 1) : 1;
+        finer = ratio * ratio;
+    }
+    else {
+        finer = BUDGET_STEP;
+    }
+    float ceiling = targetMillis * (1 + TOLERANCE);
+
+    if (smoothedMillis > ceiling){
+        framesOver++;
+        framesUnder = 0;
+    }
+    else if (smoothedMillis * finer < ceiling){
+        framesUnder++;
+        framesOver = 0;
+    }
+    else {
+        framesOver = 0;
+        framesUnder = 0;
+    }
+
+    bool bCanCoarsen = knob == SPACING ? spacing < maxSpacing : vertexBudget > minBudget;
+    bool bCanRefine = knob == SPACING ? spacing > minSpacing : vertexBudget < maxBudget;
+    if (framesOver >= SUSTAIN_FRAMES && bCanCoarsen){
+        step(1, knob);
+        return true;
+    }
+    if (framesUnder >= SUSTAIN_FRAMES && bCanRefine){
+        step(-1, knob);
+        return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+void DensityController::step(int direction, Knob knob){
+
+    // Coarser is a wider spacing or a smaller budget
+    if (knob == SPACING){
+        spacing = ofClamp(spacing + direction, minSpacing, maxSpacing);
+    }
+    else {
+        float scale = direction > 0 ? 1 / BUDGET_STEP : BUDGET_STEP;
+        vertexBudget = ofClamp(vertexBudget * scale, minBudget, maxBudget);
+    }
+
+    framesOver = 0;
+    framesUnder = 0;
+    cooldown = COOLDOWN_FRAMES;
+}
+
+//--------------------------------------------------------------
+int DensityController::getSpacing() const {
+    return spacing;
+}
+
+//--------------------------------------------------------------
+int DensityController::getVertexBudget() const {
+    return vertexBudget;
+}
+
+//--------------------------------------------------------------
+float DensityController::getTargetMillis() const {
+    return targetMillis;
+}
+
+//--------------------------------------------------------------
+float DensityController::getSmoothedMillis() const {
+    return smoothedMillis;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Holds the meshing cost near a target frame time by trading sampling
+// density for speed. Fed the measured cost every frame, it coarsens the
+// spacing or shrinks the vertex budget when we're running slow, whichever the
+// sampler in use reads, and refines it again when there's room.
+//
+// Changing density is visible, so it's careful about it: the cost has to stay
+// outside the target for a while before anything moves, it only refines when
+// the finer density is predicted to still fit, and after each step it waits
+// for the new cost to settle before it will step again.
+
+class DensityController {
+
+    public:
+        DensityController();
+
+        void setup(float targetMillis, int spacing, int minSpacing, int maxSpacing,
+                   int vertexBudget, int minBudget, int maxBudget);
+
+        // The spacing for the sampling grid, the budget for the adaptive sampler
+        enum Knob {
+            SPACING,
+            VERTEX_BUDGET
+        };
+
+        bool update(float frameMillis, Knob knob);     // True when the density changed
+
+        int getSpacing() const;
+        int getVertexBudget() const;
+        float getTargetMillis() const;
+        float getSmoothedMillis() const;
+
+    private:
+        void step(int direction, Knob knob);
+
+        float targetMillis;
+        float smoothedMillis;
+
+        int spacing;
+        int minSpacing;
+        int maxSpacing;
+        int vertexBudget;
+        int minBudget;
+        int maxBudget;
+
+        int framesOver;
+        int framesUnder;
+        int cooldown;
+};
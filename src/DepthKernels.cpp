@@ -0,0 +1,166 @@
+#include "DepthKernels.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_TARGET
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+    // Depths are unsigned but SSE only compares signed 16 bit values, so
+    // everything is shifted by flipping the top bit first.
+    const unsigned short SIGN_FLIP = 0x8000;
+
+    void thresholdScalar(const unsigned short* depth, int count, int near, int far, unsigned char* mask){
+        for (int i = 0; i < count; i++){
+            mask[i] = (depth[i] > near && depth[i] < far) ? 255 : 0;
+        }
+    }
+
+#if defined(__SSE2__)
+    int thresholdSSE2(const unsigned short* depth, int count, int near, int far, unsigned char* mask){
+        const __m128i flip = _mm_set1_epi16((short)SIGN_FLIP);
+        const __m128i lo = _mm_set1_epi16((short)(near ^ SIGN_FLIP));
+        const __m128i hi = _mm_set1_epi16((short)(far ^ SIGN_FLIP));
+
+        int i = 0;
+        for (; i + 16 <= count; i += 16){
+            __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(depth + i)), flip);
+            __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(depth + i + 8)), flip);
+            __m128i inA = _mm_and_si128(_mm_cmpgt_epi16(a, lo), _mm_cmplt_epi16(a, hi));
+            __m128i inB = _mm_and_si128(_mm_cmpgt_epi16(b, lo), _mm_cmplt_epi16(b, hi));
+
+            // 0xffff / 0 words saturate down to 0xff / 0 bytes
+            _mm_storeu_si128((__m128i*)(mask + i), _mm_packs_epi16(inA, inB));
+        }
+        return i;
+    }
+#endif
+
+#ifdef HAVE_AVX2_TARGET
+    __attribute__((target("avx2")))
+    int thresholdAVX2(const unsigned short* depth, int count, int near, int far, unsigned char* mask){
+        const __m256i flip = _mm256_set1_epi16((short)SIGN_FLIP);
+        const __m256i lo = _mm256_set1_epi16((short)(near ^ SIGN_FLIP));
+        const __m256i hi = _mm256_set1_epi16((short)(far ^ SIGN_FLIP));
+
+        int i = 0;
+        for (; i + 32 <= count; i += 32){
+            __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(depth + i)), flip);
+            __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(depth + i + 16)), flip);
+            __m256i inA = _mm256_and_si256(_mm256_cmpgt_epi16(a, lo), _mm256_cmpgt_epi16(hi, a));
+            __m256i inB = _mm256_and_si256(_mm256_cmpgt_epi16(b, lo), _mm256_cmpgt_epi16(hi, b));
+
+            // packs works within each 128 bit lane, put the quarters back in order
+            __m256i packed = _mm256_packs_epi16(inA, inB);
+            packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256((__m256i*)(mask + i), packed);
+        }
+        return i;
+    }
+#endif
+
+#if defined(__ARM_NEON)
+    // NEON compares unsigned words as they are, no flipping needed
+    int thresholdNEON(const unsigned short* depth, int count, int near, int far, unsigned char* mask){
+        const uint16x8_t lo = vdupq_n_u16((unsigned short)near);
+        const uint16x8_t hi = vdupq_n_u16((unsigned short)far);
+
+        int i = 0;
+        for (; i + 16 <= count; i += 16){
+            uint16x8_t a = vld1q_u16(depth + i);
+            uint16x8_t b = vld1q_u16(depth + i + 8);
+            uint16x8_t inA = vandq_u16(vcgtq_u16(a, lo), vcltq_u16(a, hi));
+            uint16x8_t inB = vandq_u16(vcgtq_u16(b, lo), vcltq_u16(b, hi));
+
+            // 0xffff / 0 words narrow to 0xff / 0 bytes
+            vst1q_u8(mask + i, vcombine_u8(vmovn_u16(inA), vmovn_u16(inB)));
+        }
+        return i;
+    }
+#endif
+
+    // Thresholds outside the 16 bit range would wrap in the vector compares
+    int clampDepth(int d){
+        return std::min(std::max(d, -1), 65536);
+    }
+}
+
+//--------------------------------------------------------------
+DepthKernels::InstructionSet DepthKernels::getBestInstructionSet(){
+#ifdef HAVE_AVX2_TARGET
+    static const bool bAVX2 = __builtin_cpu_supports("avx2");
+    if (bAVX2) return AVX2;
+#endif
+#if defined(__SSE2__)
+    return SSE2;
+#elif defined(__ARM_NEON)
+    return NEON;
+#else
+    return SCALAR;
+#endif
+}
+
+//--------------------------------------------------------------
+bool DepthKernels::isAvailable(InstructionSet set){
+    switch (set){
+#ifdef HAVE_AVX2_TARGET
+        case AVX2: return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__SSE2__)
+        case SSE2: return true;
+#endif
+#if defined(__ARM_NEON)
+        case NEON: return true;
+#endif
+        case SCALAR: return true;
+        default: return false;
+    }
+}
+
+//--------------------------------------------------------------
+std::string DepthKernels::getName(InstructionSet set){
+    switch (set){
+        case NEON: return "NEON";
+        case AVX2: return "AVX2";
+        case SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+//--------------------------------------------------------------
+void DepthKernels::threshold(const unsigned short* depth, int count, int near, int far, unsigned char* mask){
+    threshold(depth, count, near, far, mask, getBestInstructionSet());
+}
+
+//--------------------------------------------------------------
+void DepthKernels::threshold(const unsigned short* depth, int count, int near, int far, unsigned char* mask, InstructionSet set){
+
+    near = clampDepth(near);
+    far = clampDepth(far);
+
+    // The vector paths need both limits to fit in 16 bits, and handle
+    // everything but the last few pixels
+    int done = 0;
+    bool bFits = near >= 0 && far <= 65535;
+#ifdef HAVE_AVX2_TARGET
+    if (set == AVX2 && bFits) done = thresholdAVX2(depth, count, near, far, mask);
+#endif
+#if defined(__SSE2__)
+    if ((set == SSE2 || set == AVX2) && bFits) done += thresholdSSE2(depth + done, count - done, near, far, mask + done);
+#endif
+#if defined(__ARM_NEON)
+    if (set == NEON && bFits) done = thresholdNEON(depth, count, near, far, mask);
+#endif
+    thresholdScalar(depth + done, count - done, near, far, mask + done);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+// Per-pixel kernels over the raw kinect depth buffer. Each has a scalar
+// version and SSE2 / AVX2 versions picked at runtime where the CPU has them.
+//
+// The instruction sets are shared by all the kernels. On ARM the only one
+// past scalar is NEON, which the threshold and the noise kernels have a
+// version for. The rest run their scalar version there.
+
+namespace DepthKernels {
+
+    enum InstructionSet {
+        SCALAR,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    InstructionSet getBestInstructionSet();
+    bool isAvailable(InstructionSet set);   // Whether this build and CPU can run it
+    std::string getName(InstructionSet set);
+
+    // mask[i] = 255 where near < depth[i] < far, 0 everywhere else
+    void threshold(const unsigned short* depth, int count, int near, int far, unsigned char* mask);
+    void threshold(const unsigned short* depth, int count, int near, int far, unsigned char* mask, InstructionSet set);
+}
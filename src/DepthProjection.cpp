@@ -0,0 +1,42 @@
+#include "DepthProjection.h"
+
+//--------------------------------------------------------------
+void DepthProjection::setup(KinectSource& source){
+
+    int width = source.getWidth();
+    int height = source.getHeight();
+    float depth = 1000;
+
+    // Sample the source's own projection along one row and one column, the
+    // rest is linear in depth
+    xScale.resize(width);
+    yScale.resize(height);
+    for (int x = 0; x < width; x++){
+        xScale[x] = source.getWorldCoordinateAt((float)x, height / 2.0f, depth).x / depth;
+    }
+    for (int y = 0; y < height; y++){
+        yScale[y] = source.getWorldCoordinateAt(width / 2.0f, (float)y, depth).y / depth;
+    }
+
+    // Make sure that held for this source
+    ofVec3f expected = source.getWorldCoordinateAt(width - 1.0f, height - 1.0f, 2 * depth);
+    ofVec3f table = unproject(width - 1, height - 1, 2 * depth);
+    if (fabs(expected.x - table.x) > 0.01 || fabs(expected.y - table.y) > 0.01){
+        ofLogWarning("DepthProjection") << "source projection isn't separable, unprojected points will be off";
+    }
+}
+
+//--------------------------------------------------------------
+void DepthProjection::unprojectRow(const unsigned short* depthRow, int y, int x0, int step, int count, ofVec3f* out) const {
+
+    const float ys = yScale[y];
+    const float* xs = &xScale[x0];
+    const unsigned short* d = depthRow + x0;
+
+    for (int i = 0; i < count; i++){
+        float z = d[i * step];
+        out[i].x = xs[i * step] * z;
+        out[i].y = ys * z;
+        out[i].z = z;
+    }
+}
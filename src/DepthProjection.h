@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ofMain.h"
+#include "KinectSource.h"
+
+// Depth image to world space, from per-column and per-row scale factors
+// worked out once for the source's resolution. Unprojecting a pixel is then
+// a multiply per axis instead of the full intrinsics calculation.
+
+class DepthProjection {
+
+    public:
+        void setup(KinectSource& source);
+
+        int getWidth() const { return xScale.size(); }
+        int getHeight() const { return yScale.size(); }
+
+        ofVec3f unproject(int x, int y, float depth) const {
+            return ofVec3f(xScale[x] * depth, yScale[y] * depth, depth);
+        }
+
+        // Unproject count pixels of row y starting at x0 and step apart, from
+        // that row of the raw depth buffer
+        void unprojectRow(const unsigned short* depthRow, int y, int x0, int step, int count, ofVec3f* out) const;
+
+    private:
+        vector<float> xScale;
+        vector<float> yScale;
+};
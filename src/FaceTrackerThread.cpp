@@ -0,0 +1,207 @@
+#include "FaceTrackerThread.h"
+
+using namespace ofxCv;
+
+static const float FACE_WIDTH = 55.0;       // Roughly a face's width in pixels at tracker scale 1
+static const float ROI_PADDING = 1.5;       // Search this many face widths either side of the prediction
+static const float ROI_MIN_SIZE = 160;      // Any smaller and detection starts to struggle
+static const float ROI_EDGE_MARGIN = 0.25;  // Face widths from the window's edge that move it
+static const float VELOCITY_SMOOTHING = 0.5;
+
+//--------------------------------------------------------------
+FaceTrackerThread::FaceTrackerThread()
+: bThreaded(true), bInputReady(false), bResetRequested(false), bRoiEnabled(true),
+  bTracking(false), lastScale(0), lastFrameIndex(-1), bSnapshotNew(false){
+}
+
+//--------------------------------------------------------------
+FaceTrackerThread::~FaceTrackerThread(){
+    stop();
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::setup(bool threaded){
+
+    tracker.setup();
+    tracker.setRescale(.5);
+
+    bThreaded = threaded;
+    if (bThreaded) startThread();
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::stop(){
+    if (isThreadRunning()){
+        {
+            std::unique_lock<std::mutex> lock(inputMutex);
+            stopThread();
+        }
+        inputCondition.notify_one();
+        waitForThread(false);
+    }
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::submit(shared_ptr<const KinectFrame> frame){
+
+    if (bInputReady || frame == NULL || !frame->color.isAllocated()) return;
+
+    input = frame;
+    {
+        std::unique_lock<std::mutex> lock(inputMutex);
+        bInputReady = true;
+    }
+    inputCondition.notify_one();
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::update(){
+    if (!bThreaded && bInputReady) track();
+    bSnapshotNew = snapshots.consume();
+}
+
+//--------------------------------------------------------------
+const FaceSnapshot& FaceTrackerThread::getSnapshot() const {
+    return snapshots.getFront();
+}
+
+//--------------------------------------------------------------
+bool FaceTrackerThread::isSnapshotNew() const {
+    return bSnapshotNew;
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::reset(){
+    bResetRequested = true;
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::setRoiEnabled(bool enabled){
+    bRoiEnabled = enabled;
+}
+
+//--------------------------------------------------------------
+bool FaceTrackerThread::getRoiEnabled() const {
+    return bRoiEnabled;
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::threadedFunction(){
+    while (isThreadRunning()){
+        {
+            std::unique_lock<std::mutex> lock(inputMutex);
+            inputCondition.wait(lock, [this]{ return bInputReady || !isThreadRunning(); });
+        }
+        if (bInputReady) track();
+    }
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::track(){
+
+    // The tracker is only ever touched from here, so a reset has to wait its turn
+    if (bResetRequested){
+        tracker.reset();
+        bTracking = false;
+        bResetRequested = false;
+    }
+
+    // The tracker's idea of where the face was is relative to the image it
+    // was last given, so moving the window, or between it and the full
+    // frame, means starting it afresh.
+    ofRectangle area = getSearchArea();
+    if (area.x != window.x || area.y != window.y || area.width != window.width || area.height != window.height){
+        tracker.reset();
+        window = area;
+    }
+    bool bRoi = area.width < input->color.getWidth() || area.height < input->color.getHeight();
+
+    // A window onto the shared frame, not a copy of it. The tracker only
+    // reads it, toCv() just won't take it const.
+    cv::Mat image = toCv(const_cast<ofPixels&>(input->color));
+    if (bRoi) image = image(cv::Rect(area.x, area.y, area.width, area.height));
+    tracker.update(image);
+
+    bool bFound = tracker.getFound();
+    ofVec2f position = tracker.getPosition();
+    position.x += area.x;
+    position.y += area.y;
+    updatePrediction(bFound, position, tracker.getScale());
+
+    FaceSnapshot& snapshot = snapshots.getBack();
+    snapshot.bFound = bFound;
+    snapshot.position = position;
+    snapshot.scale = tracker.getScale();
+    snapshot.searchArea = area;
+    snapshot.frameIndex = input->index;
+
+    snapshot.features.clear();
+    if (snapshot.bFound){
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::LEFT_EYE));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::RIGHT_EYE));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::LEFT_EYEBROW));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::RIGHT_EYEBROW));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::NOSE_BRIDGE));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::NOSE_BASE));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::INNER_MOUTH));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::OUTER_MOUTH));
+        snapshot.features.push_back(tracker.getImageFeature(ofxFaceTracker::JAW));
+    }
+    snapshots.publish();
+
+    // Ready for the next frame, and the capture thread can have this one back
+    input.reset();
+    bInputReady = false;
+}
+
+//--------------------------------------------------------------
+ofRectangle FaceTrackerThread::getSearchArea(){
+
+    ofRectangle frame(0, 0, input->color.getWidth(), input->color.getHeight());
+    if (!bRoiEnabled || !bTracking) return frame;
+
+    // Where the face should be by the frame we're about to look at
+    int elapsed = input->index - lastFrameIndex;
+    ofVec2f predicted(lastPosition.x + velocity.x * elapsed, lastPosition.y + velocity.y * elapsed);
+
+    float size = std::max(ROI_MIN_SIZE, 2 * ROI_PADDING * lastScale * FACE_WIDTH);
+    size = std::min(size, std::min(frame.width, frame.height));
+
+    // Hold the window still while the face is well inside it, so the
+    // tracker's last shape stays where it left it. It only moves once the
+    // face nears an edge or outgrows it.
+    bool bInWindow = window.width < frame.width || window.height < frame.height;
+    float reach = lastScale * FACE_WIDTH * (0.5 + ROI_EDGE_MARGIN);
+    if (bInWindow && window.width >= floor(size)
+        && predicted.x - reach >= window.x && predicted.x + reach <= window.x + window.width
+        && predicted.y - reach >= window.y && predicted.y + reach <= window.y + window.height){
+        return window;
+    }
+
+    float x = ofClamp(predicted.x - size / 2, 0, frame.width - size);
+    float y = ofClamp(predicted.y - size / 2, 0, frame.height - size);
+    return ofRectangle(floor(x), floor(y), floor(size), floor(size));
+}
+
+//--------------------------------------------------------------
+void FaceTrackerThread::updatePrediction(bool bFound, const ofVec2f& position, float scale){
+
+    if (!bFound){
+        // Lost it, go back to searching everywhere
+        bTracking = false;
+        velocity = ofVec2f();
+        return;
+    }
+
+    int elapsed = input->index - lastFrameIndex;
+    if (bTracking && elapsed > 0){
+        ofVec2f measured((position.x - lastPosition.x) / elapsed, (position.y - lastPosition.y) / elapsed);
+        velocity.x = ofLerp(velocity.x, measured.x, VELOCITY_SMOOTHING);
+        velocity.y = ofLerp(velocity.y, measured.y, VELOCITY_SMOOTHING);
+    }
+
+    bTracking = true;
+    lastPosition = position;
+    lastScale = scale;
+    lastFrameIndex = input->index;
+}
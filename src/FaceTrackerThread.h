@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxFaceTracker.h"
+#include "KinectFrame.h"
+#include "TripleBuffer.h"
+
+// What the tracker knew about the face the last time it ran.
+struct FaceSnapshot {
+    bool bFound = false;
+    ofVec2f position;
+    float scale = 0;
+    vector<ofPolyline> features;    // Outlines relative to searchArea, for the debug view
+    ofRectangle searchArea;         // The part of the frame the tracker looked at
+    int frameIndex = -1;            // The KinectFrame it was found in
+};
+
+// Runs ofxFaceTracker on its own thread at whatever rate it can manage. The
+// render loop offers it frames and reads back the newest snapshot; neither
+// side ever waits on the other. Frames offered while it's busy are ignored.
+//
+// Once it has a face it only searches a padded window around where it expects
+// the face to be next, predicted from its last couple of positions. At
+// installation distance the face is a small part of the frame, so this is
+// far cheaper than the full frame, which it goes back to as soon as it loses
+// the face. The tracker's last shape is relative to the window, so the window
+// stays put until the face nears its edge, and the tracker starts afresh
+// whenever it moves.
+//
+// Like the CaptureThread it can run synchronously instead, for deterministic
+// replays.
+
+class FaceTrackerThread : public ofThread {
+
+    public:
+        FaceTrackerThread();
+        ~FaceTrackerThread();
+
+        void setup(bool threaded = true);
+        void stop();
+
+        // Holds on to the frame until it's been tracked, nothing's copied.
+        // A cheap no-op if the tracker is still busy.
+        void submit(shared_ptr<const KinectFrame> frame);
+        void update();                          // Call once per frame from the render loop
+
+        const FaceSnapshot& getSnapshot() const;
+        bool isSnapshotNew() const;
+
+        void reset();   // Forget the face, safe to call from any thread
+
+        void setRoiEnabled(bool enabled);
+        bool getRoiEnabled() const;
+
+    private:
+        void threadedFunction();
+        void track();
+        ofRectangle getSearchArea();
+        void updatePrediction(bool bFound, const ofVec2f& position, float scale);
+
+        ofxFaceTracker tracker;
+        bool bThreaded;
+
+        // The frame being tracked. Only written while bInputReady is false,
+        // only read by the tracker while it's true, and let go once it's done.
+        shared_ptr<const KinectFrame> input;
+        std::atomic<bool> bInputReady;
+        std::atomic<bool> bResetRequested;
+        std::atomic<bool> bRoiEnabled;
+
+        // Motion predictor, in full frame coordinates. Only used by the tracker.
+        bool bTracking;
+        ofRectangle window;     // The area the tracker was last given
+        ofVec2f lastPosition;
+        ofVec2f velocity;       // Pixels per kinect frame
+        float lastScale;
+        int lastFrameIndex;
+        std::mutex inputMutex;
+        std::condition_variable inputCondition;
+
+        TripleBuffer<FaceSnapshot> snapshots;
+        bool bSnapshotNew;
+};
@@ -0,0 +1,94 @@
+#include "GridMesher.h"
+
+//--------------------------------------------------------------
+GridMesher::GridMesher()
+:width(0)
+,height(0)
+,spacing(0)
+,samplesX(0)
+,samplesY(0){
+}
+
+//--------------------------------------------------------------
+void GridMesher::setup(int width, int height, int spacing){
+
+    this->width = width;
+    this->height = height;
+    this->spacing = spacing;
+    samplesX = (width + spacing - 1) / spacing;
+    samplesY = (height + spacing - 1) / spacing;
+
+    depths.assign(samplesX * samplesY, 0);
+    vertices.resize(samplesX * samplesY);
+    for (int sy = 0; sy < samplesY; sy++){
+        for (int sx = 0; sx < samplesX; sx++){
+            vertices[sx + sy * samplesX].set(sx * spacing - width / 2.0, sy * spacing - height / 2.0, 0);
+        }
+    }
+
+    // Two triangles a cell at most
+    indices.clear();
+    indices.reserve((samplesX - 1) * (samplesY - 1) * 6);
+}
+
+//--------------------------------------------------------------
+void GridMesher::update(const KinectFrame& frame, const unsigned char* mask, int spacing, float near, float far){
+
+    if (frame.getWidth() != width || frame.getHeight() != height || spacing != this->spacing){
+        setup(frame.getWidth(), frame.getHeight(), spacing);
+    }
+
+    for (int sy = 0; sy < samplesY; sy++){
+        for (int sx = 0; sx < samplesX; sx++){
+            int x = sx * spacing;
+            int y = sy * spacing;
+            int sample = sx + sy * samplesX;
+            float depth = 0;
+            if (mask[x + y * width] > 0){
+                depth = frame.getDistanceAt(x, y);
+                if (depth <= near || depth >= far) depth = 0;
+            }
+            depths[sample] = depth;
+            vertices[sample].z = -depth;
+        }
+    }
+
+    indices.clear();
+    for (int sy = 0; sy + 1 < samplesY; sy++){
+        for (int sx = 0; sx + 1 < samplesX; sx++){
+
+            // a b
+            // c d
+            int a = sx + sy * samplesX;
+            int b = a + 1;
+            int c = a + samplesX;
+            int d = c + 1;
+            bool bA = depths[a] > 0;
+            bool bB = depths[b] > 0;
+            bool bC = depths[c] > 0;
+            bool bD = depths[d] > 0;
+
+            if (bA && bB && bC && bD){
+                if (fabs(depths[a] - depths[d]) <= fabs(depths[b] - depths[c])){
+                    addTriangle(a, b, d);
+                    addTriangle(a, d, c);
+                }
+                else {
+                    addTriangle(a, b, c);
+                    addTriangle(b, d, c);
+                }
+            }
+            else if (bA && bB && bC) addTriangle(a, b, c);
+            else if (bA && bB && bD) addTriangle(a, b, d);
+            else if (bA && bD && bC) addTriangle(a, d, c);
+            else if (bB && bD && bC) addTriangle(b, d, c);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void GridMesher::addTriangle(int a, int b, int c){
+    indices.push_back(a);
+    indices.push_back(b);
+    indices.push_back(c);
+}
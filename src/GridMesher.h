@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofMain.h"
+#include "KinectFrame.h"
+
+// Meshes the depth image straight off its sampling grid: every grid cell
+// with three or four valid corners becomes one or two triangles. That's
+// linear in the number of samples, where a general Delaunay is O(n log n) at
+// best and ignores that the points were on a grid to begin with.
+//
+// A full cell is split along whichever diagonal spans the smaller depth
+// difference, so the fold follows the surface rather than cutting across
+// a nose or a jaw line.
+
+class GridMesher {
+
+    public:
+        GridMesher();
+
+        void update(const KinectFrame& frame, const unsigned char* mask, int spacing, float near, float far);
+
+        // One vertex per grid sample, valid or not; the indices only ever
+        // refer to valid ones
+        const vector<ofVec3f>& getVertices() const { return vertices; }
+        const vector<int>& getIndices() const { return indices; }
+        int getNumTriangles() const { return indices.size() / 3; }
+
+    private:
+        void setup(int width, int height, int spacing);
+        void addTriangle(int a, int b, int c);
+
+        int width;
+        int height;
+        int spacing;
+        int samplesX;
+        int samplesY;
+
+        vector<float> depths;       // 0 where the sample is off the mask
+        vector<ofVec3f> vertices;
+        vector<int> indices;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ofMain.h"
+
+// One complete depth + RGB frame, as handed from the capture thread to the
+// render loop.
+
+struct KinectFrame {
+
+    ofShortPixels rawDepth;     // Millimetres, 0 == no reading
+    ofPixels depth;             // 8 bit, for display
+    ofPixels color;
+    int index = -1;             // Counts up from the first captured frame
+
+    int getWidth() const { return rawDepth.getWidth(); }
+    int getHeight() const { return rawDepth.getHeight(); }
+
+    float getDistanceAt(int x, int y) const {
+        return rawDepth[x + y * rawDepth.getWidth()];
+    }
+
+    ofColor getColorAt(int x, int y) const {
+        return color.getColor(x, y);
+    }
+};
@@ -0,0 +1,550 @@
+#include "KinectRecording.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const size_t HEADER_BYTES = 20;
+static const size_t CHUNK_HEADER_BYTES = 20;
+static const size_t INDEX_ENTRY_BYTES = 16;
+static const size_t FOOTER_BYTES = 12;
+static const uint32_t MAX_DIMENSION = 4096;     // Well past any kinect, to catch a corrupt header
+
+static const int MAX_QUEUED = 30;   // About a second of frames waiting to be encoded
+
+template<typename T>
+static T readAt(const unsigned char* p){
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template<typename T>
+static void write(FILE* file, const T& value){
+    fwrite(&value, sizeof(T), 1, file);
+}
+
+
+
+
+
+//--------------------------------------------------------------
+// Depth codec. Each pixel is predicted from its left, upper and upper left
+// neighbours (the LOCO-I median edge detector), and the zigzagged residual is
+// Rice coded with a parameter that adapts to the running mean, so flat
+// surfaces cost a couple of bits a pixel and edges escape to a raw value.
+
+namespace {
+
+    const int RICE_LIMIT = 24;  // Longest unary prefix before escaping to a raw value
+    const int RAW_BITS = 17;    // Enough for any zigzagged 16 bit residual
+
+    struct BitWriter {
+        vector<unsigned char>& out;
+        uint64_t acc;
+        int bits;
+
+        BitWriter(vector<unsigned char>& out) : out(out), acc(0), bits(0){}
+
+        void put(uint32_t value, int n){
+            acc |= (uint64_t)value << bits;
+            bits += n;
+            while (bits >= 8){
+                out.push_back(acc & 0xff);
+                acc >>= 8;
+                bits -= 8;
+            }
+        }
+
+        void flush(){
+            if (bits > 0) out.push_back(acc & 0xff);
+            acc = 0;
+            bits = 0;
+        }
+    };
+
+    struct BitReader {
+        const unsigned char* start;
+        const unsigned char* p;
+        const unsigned char* end;
+        uint64_t acc;
+        int bits;
+
+        BitReader(const unsigned char* in, size_t bytes) : start(in), p(in), end(in + bytes), acc(0), bits(0){}
+
+        void refill(){
+            while (bits <= 56){
+                uint64_t b = p < end ? *p : 0;
+                p++;
+                acc |= b << bits;
+                bits += 8;
+            }
+        }
+
+        uint32_t get(int n){
+            refill();
+            uint32_t value = acc & ((1ull << n) - 1);
+            acc >>= n;
+            bits -= n;
+            return value;
+        }
+
+        // Count the run of 1 bits, up to limit
+        int ones(int limit){
+            refill();
+            uint64_t inverted = ~acc;
+            int n = inverted == 0 ? 64 : __builtin_ctzll(inverted);
+            if (n > limit) n = limit;
+            acc >>= n;
+            bits -= n;
+            return n;
+        }
+
+        bool overran() const {
+            return (p - start) - bits / 8 > end - start;
+        }
+    };
+
+    struct RiceContext {
+        int a;
+        int n;
+
+        RiceContext() : a(4), n(1){}
+
+        int k() const {
+            int k = 0;
+            while ((n << k) < a && k < 16) k++;
+            return k;
+        }
+
+        void update(uint32_t u){
+            a += u;
+            if (++n == 64){
+                a >>= 1;
+                n >>= 1;
+            }
+        }
+    };
+
+    inline int predict(const unsigned short* row, const unsigned short* above, int x){
+        if (above == NULL) return x > 0 ? row[x - 1] : 0;
+        if (x == 0) return above[0];
+
+        int a = row[x - 1];
+        int b = above[x];
+        int c = above[x - 1];
+        int lo = std::min(a, b);
+        int hi = std::max(a, b);
+        if (c >= hi) return lo;
+        if (c <= lo) return hi;
+        return a + b - c;
+    }
+}
+
+//--------------------------------------------------------------
+void DepthCodec::encode(const unsigned short* depth, int width, int height, vector<unsigned char>& out){
+
+    out.clear();
+    BitWriter writer(out);
+    RiceContext context;
+
+    for (int y = 0; y < height; y++){
+        const unsigned short* row = depth + y * width;
+        const unsigned short* above = y > 0 ? row - width : NULL;
+
+        for (int x = 0; x < width; x++){
+            int e = row[x] - predict(row, above, x);
+            uint32_t u = e >= 0 ? 2 * e : -2 * e - 1;
+
+            int k = context.k();
+            uint32_t q = u >> k;
+            if (q < (uint32_t)RICE_LIMIT){
+                writer.put((1u << q) - 1, q + 1);   // q ones and a terminating zero
+                writer.put(u & ((1u << k) - 1), k);
+            }
+            else {
+                writer.put((1u << RICE_LIMIT) - 1, RICE_LIMIT);
+                writer.put(u, RAW_BITS);
+            }
+            context.update(u);
+        }
+    }
+    writer.flush();
+}
+
+//--------------------------------------------------------------
+bool DepthCodec::decode(const unsigned char* in, size_t bytes, int width, int height, unsigned short* depth){
+
+    BitReader reader(in, bytes);
+    RiceContext context;
+
+    for (int y = 0; y < height; y++){
+        unsigned short* row = depth + y * width;
+        const unsigned short* above = y > 0 ? row - width : NULL;
+
+        for (int x = 0; x < width; x++){
+            int k = context.k();
+            int q = reader.ones(RICE_LIMIT);
+            uint32_t u;
+            if (q < RICE_LIMIT){
+                reader.get(1);
+                u = ((uint32_t)q << k) | reader.get(k);
+            }
+            else {
+                u = reader.get(RAW_BITS);
+            }
+            context.update(u);
+
+            int e = (u >> 1) ^ -(int)(u & 1);
+            row[x] = predict(row, above, x) + e;
+        }
+    }
+    return !reader.overran();
+}
+
+
+
+
+
+//--------------------------------------------------------------
+KinectRecorder::KinectRecorder()
+: numQueued(0), numWritten(0), numDropped(0),
+  file(NULL), width(0), height(0), bRecording(false), startTime(0){
+}
+
+//--------------------------------------------------------------
+KinectRecorder::~KinectRecorder(){
+    stop();
+}
+
+//--------------------------------------------------------------
+bool KinectRecorder::start(const string& path, int width, int height, float worldScale){
+
+    if (bRecording) stop();
+
+    file = fopen(ofToDataPath(path).c_str(), "wb");
+    if (file == NULL){
+        ofLogError("KinectRecorder") << "couldn't create " << path;
+        return false;
+    }
+
+    this->path = path;
+    this->width = width;
+    this->height = height;
+    offsets.clear();
+    timestamps.clear();
+    numQueued = 0;
+    numWritten = 0;
+    numDropped = 0;
+    startTime = 0;
+
+    fwrite("CGRS", 1, 4, file);
+    write<uint32_t>(file, KinectRecording::VERSION);
+    write<uint32_t>(file, width);
+    write<uint32_t>(file, height);
+    write<float>(file, worldScale);
+
+    bRecording = true;
+    startThread();
+
+    ofLogNotice("KinectRecorder") << "recording to " << path;
+    return true;
+}
+
+//--------------------------------------------------------------
+void KinectRecorder::stop(){
+
+    if (!bRecording) return;
+    bRecording = false;
+
+    // An empty frame tells the writer it has everything, let it drain the queue
+    Frame end;
+    end.timestamp = 0;
+    frames.send(end);
+    waitForThread(false);
+
+    uint64_t indexOffset = ftello(file);
+    fwrite("INDX", 1, 4, file);
+    write<uint32_t>(file, offsets.size());
+    for (size_t i = 0; i < offsets.size(); i++){
+        write<uint64_t>(file, offsets[i]);
+        write<uint64_t>(file, timestamps[i]);
+    }
+    write<uint64_t>(file, indexOffset);
+    fwrite("CGRX", 1, 4, file);
+    fclose(file);
+    file = NULL;
+
+    ofLogNotice("KinectRecorder") << "wrote " << numWritten << " frames to " << path
+                                  << ", dropped " << numDropped;
+}
+
+//--------------------------------------------------------------
+bool KinectRecorder::isRecording() const {
+    return bRecording;
+}
+
+//--------------------------------------------------------------
+void KinectRecorder::addFrame(const ofShortPixels& depth, const ofPixels& color){
+
+    if (!bRecording) return;
+
+    // If the encoder can't keep up drop frames rather than queue them forever
+    if (numQueued >= MAX_QUEUED){
+        numDropped++;
+        return;
+    }
+
+    uint64_t now = ofGetElapsedTimeMicros();
+    if (numQueued == 0 && numWritten == 0 && startTime == 0) startTime = now;
+
+    Frame frame;
+    frame.timestamp = now - startTime;
+    frame.depth = depth;
+    frame.color = color;
+
+    numQueued++;
+    frames.send(std::move(frame));
+}
+
+//--------------------------------------------------------------
+int KinectRecorder::getNumFrames() const {
+    return numWritten;
+}
+
+//--------------------------------------------------------------
+int KinectRecorder::getNumDropped() const {
+    return numDropped;
+}
+
+//--------------------------------------------------------------
+void KinectRecorder::threadedFunction(){
+    Frame frame;
+    while (frames.receive(frame)){
+        if (!frame.depth.isAllocated()) break;
+        writeFrame(frame);
+        numQueued--;
+        numWritten++;
+    }
+}
+
+//--------------------------------------------------------------
+void KinectRecorder::writeFrame(const Frame& frame){
+
+    DepthCodec::encode(frame.depth.getData(), width, height, depthScratch);
+
+    ofBuffer jpeg;
+    ofSaveImage(frame.color, jpeg, OF_IMAGE_FORMAT_JPEG, OF_IMAGE_QUALITY_HIGH);
+
+    offsets.push_back(ftello(file));
+    timestamps.push_back(frame.timestamp);
+
+    fwrite("FRAM", 1, 4, file);
+    write<uint32_t>(file, depthScratch.size());
+    write<uint32_t>(file, jpeg.size());
+    write<uint64_t>(file, frame.timestamp);
+    fwrite(&depthScratch[0], 1, depthScratch.size(), file);
+    fwrite(jpeg.getData(), 1, jpeg.size(), file);
+}
+
+
+
+
+
+//--------------------------------------------------------------
+KinectRecording::KinectRecording()
+: data(NULL), size(0), fd(-1), width(0), height(0), worldScale(0){
+}
+
+//--------------------------------------------------------------
+KinectRecording::~KinectRecording(){
+    close();
+}
+
+//--------------------------------------------------------------
+bool KinectRecording::open(const string& path){
+
+    close();
+
+    fd = ::open(ofToDataPath(path).c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < HEADER_BYTES){
+        ofLogError("KinectRecording") << "couldn't open " << path;
+        close();
+        return false;
+    }
+
+    size = info.st_size;
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED){
+        ofLogError("KinectRecording") << "couldn't map " << path;
+        close();
+        return false;
+    }
+    data = (const unsigned char*)mapped;
+
+    if (memcmp(data, "CGRS", 4) != 0 || readAt<uint32_t>(data + 4) != VERSION){
+        ofLogError("KinectRecording") << path << " is not a version " << VERSION << " recording";
+        close();
+        return false;
+    }
+    uint32_t headerWidth = readAt<uint32_t>(data + 8);
+    uint32_t headerHeight = readAt<uint32_t>(data + 12);
+    if (headerWidth == 0 || headerHeight == 0 || headerWidth > MAX_DIMENSION || headerHeight > MAX_DIMENSION){
+        ofLogError("KinectRecording") << path << " has a corrupt header, " << headerWidth << "x" << headerHeight;
+        close();
+        return false;
+    }
+    width = headerWidth;
+    height = headerHeight;
+    worldScale = readAt<float>(data + 16);
+
+    if (!readIndex()){
+        ofLogWarning("KinectRecording") << path << " has no index, it may have been cut short. Rebuilding it";
+        if (!rebuildIndex()){
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+bool KinectRecording::readIndex(){
+
+    if (size < HEADER_BYTES + FOOTER_BYTES) return false;
+
+    const unsigned char* footer = data + size - FOOTER_BYTES;
+    if (memcmp(footer + 8, "CGRX", 4) != 0) return false;
+
+    // The offsets are read off the disk, so every bound is checked by
+    // subtracting from one that's known good rather than adding to them
+    uint64_t indexOffset = readAt<uint64_t>(footer);
+    uint64_t indexEnd = size - FOOTER_BYTES;
+    if (indexOffset < HEADER_BYTES || indexOffset > indexEnd - 8) return false;
+
+    const unsigned char* index = data + indexOffset;
+    if (memcmp(index, "INDX", 4) != 0) return false;
+
+    uint32_t count = readAt<uint32_t>(index + 4);
+    if ((uint64_t)count * INDEX_ENTRY_BYTES > indexEnd - indexOffset - 8) return false;
+
+    offsets.resize(count);
+    timestamps.resize(count);
+    for (uint32_t i = 0; i < count; i++){
+        offsets[i] = readAt<uint64_t>(index + 8 + i * INDEX_ENTRY_BYTES);
+        timestamps[i] = readAt<uint64_t>(index + 16 + i * INDEX_ENTRY_BYTES);
+
+        // Every chunk has to be whole and in front of the index, then
+        // readFrame() can take its sizes as read
+        if (offsets[i] < HEADER_BYTES || offsets[i] > indexOffset - CHUNK_HEADER_BYTES) return false;
+        const unsigned char* chunk = data + offsets[i];
+        if (memcmp(chunk, "FRAM", 4) != 0) return false;
+        uint64_t room = indexOffset - CHUNK_HEADER_BYTES - offsets[i];
+        uint64_t depthBytes = readAt<uint32_t>(chunk + 4);
+        uint64_t colorBytes = readAt<uint32_t>(chunk + 8);
+        if (depthBytes > room || colorBytes > room - depthBytes) return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+bool KinectRecording::rebuildIndex(){
+
+    offsets.clear();
+    timestamps.clear();
+
+    uint64_t offset = HEADER_BYTES;
+    while (offset + CHUNK_HEADER_BYTES <= size && memcmp(data + offset, "FRAM", 4) == 0){
+        uint64_t end = offset + CHUNK_HEADER_BYTES
+                     + readAt<uint32_t>(data + offset + 4)
+                     + readAt<uint32_t>(data + offset + 8);
+        if (end > size) break; // Half written
+        offsets.push_back(offset);
+        timestamps.push_back(readAt<uint64_t>(data + offset + 12));
+        offset = end;
+    }
+    return !offsets.empty();
+}
+
+//--------------------------------------------------------------
+void KinectRecording::close(){
+    if (data != NULL) munmap((void*)data, size);
+    if (fd >= 0) ::close(fd);
+    data = NULL;
+    size = 0;
+    fd = -1;
+    offsets.clear();
+    timestamps.clear();
+}
+
+//--------------------------------------------------------------
+bool KinectRecording::isOpen() const {
+    return data != NULL;
+}
+
+//--------------------------------------------------------------
+int KinectRecording::getNumFrames() const {
+    return offsets.size();
+}
+
+//--------------------------------------------------------------
+int KinectRecording::getWidth() const {
+    return width;
+}
+
+//--------------------------------------------------------------
+int KinectRecording::getHeight() const {
+    return height;
+}
+
+//--------------------------------------------------------------
+float KinectRecording::getWorldScale() const {
+    return worldScale;
+}
+
+//--------------------------------------------------------------
+uint64_t KinectRecording::getTimestamp(int frame) const {
+    return timestamps[frame];
+}
+
+//--------------------------------------------------------------
+bool KinectRecording::readFrame(int frame, ofShortPixels& depth, ofPixels& color){
+
+    if (frame < 0 || frame >= getNumFrames()) return false;
+
+    // The index only holds chunks that were checked whole when it was read
+    const unsigned char* chunk = data + offsets[frame];
+    uint32_t depthBytes = readAt<uint32_t>(chunk + 4);
+    uint32_t colorBytes = readAt<uint32_t>(chunk + 8);
+    const unsigned char* depthData = chunk + CHUNK_HEADER_BYTES;
+    const unsigned char* colorData = depthData + depthBytes;
+
+    if (depth.getWidth() != width || depth.getHeight() != height) depth.allocate(width, height, 1);
+    if (!DepthCodec::decode(depthData, depthBytes, width, height, depth.getData())){
+        ofLogWarning("KinectRecording") << "frame " << frame << " depth is corrupt";
+        return false;
+    }
+
+    ofBuffer jpeg((const char*)colorData, colorBytes);
+    if (!ofLoadImage(color, jpeg) || color.getWidth() != width || color.getHeight() != height){
+        ofLogWarning("KinectRecording") << "frame " << frame << " color is corrupt";
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void KinectRecording::prefetch(int frame){
+
+    if (frame < 0 || frame >= getNumFrames()) return;
+
+    uint64_t start = offsets[frame];
+    uint64_t end = frame + 1 < getNumFrames() ? offsets[frame + 1] : size;
+
+    // madvise wants a page aligned address
+    uint64_t page = getpagesize();
+    uint64_t alignedStart = start - start % page;
+    madvise((void*)(data + alignedStart), end - alignedStart, MADV_WILLNEED);
+}
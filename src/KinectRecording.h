@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Recorded kinect sessions.
+//
+// A recording is a header, one chunk per frame and a frame index at the end,
+// all little endian:
+//
+//      header  "CGRS"  uint32 version  uint32 width  uint32 height
+//              float worldScale        (2 * zero plane pixel size / zero plane distance)
+//      frame   "FRAM"  uint32 depthBytes  uint32 colorBytes  uint64 timestamp (micros)
+//              depth   Rice coded residuals of a median edge predictor, lossless
+//              color   JPEG
+//      frame   ...
+//      index   "INDX"  uint32 numFrames  { uint64 offset  uint64 timestamp } * numFrames
+//      footer  uint64 indexOffset  "CGRX"
+//
+// If a recording was cut short and has no footer, the reader rebuilds the
+// index by walking the frame chunks.
+
+//--------------------------------------------------------------
+// Encodes and writes frames on its own thread, so recording doesn't cost the
+// update loop more than a copy of each frame.
+
+class KinectRecorder : public ofThread {
+
+    public:
+        KinectRecorder();
+        ~KinectRecorder();
+
+        bool start(const string& path, int width, int height, float worldScale);
+        void stop();
+        bool isRecording() const;
+
+        void addFrame(const ofShortPixels& depth, const ofPixels& color);
+
+        int getNumFrames() const;
+        int getNumDropped() const;
+
+    private:
+        struct Frame {
+            uint64_t timestamp;
+            ofShortPixels depth;
+            ofPixels color;
+        };
+
+        void threadedFunction();
+        void writeFrame(const Frame& frame);
+
+        ofThreadChannel<Frame> frames;
+        std::atomic<int> numQueued;
+        std::atomic<int> numWritten;
+        std::atomic<int> numDropped;
+
+        FILE* file;
+        string path;
+        int width;
+        int height;
+        bool bRecording;
+        uint64_t startTime;
+
+        vector<uint64_t> offsets;
+        vector<uint64_t> timestamps;
+        vector<unsigned char> depthScratch;
+};
+
+//--------------------------------------------------------------
+// Reads a recording through a memory map. Any frame can be decoded directly
+// from the index, and upcoming frames can be paged in ahead of time.
+
+class KinectRecording {
+
+    public:
+        KinectRecording();
+        ~KinectRecording();
+
+        bool open(const string& path);
+        void close();
+        bool isOpen() const;
+
+        int getNumFrames() const;
+        int getWidth() const;
+        int getHeight() const;
+        float getWorldScale() const;
+        uint64_t getTimestamp(int frame) const;
+
+        bool readFrame(int frame, ofShortPixels& depth, ofPixels& color);
+        void prefetch(int frame);   // Ask the OS to start reading a frame in
+
+        static const uint32_t VERSION = 2;
+
+    private:
+        bool readIndex();
+        bool rebuildIndex();
+
+        const unsigned char* data;
+        size_t size;
+        int fd;
+
+        int width;
+        int height;
+        float worldScale;
+
+        vector<uint64_t> offsets;
+        vector<uint64_t> timestamps;
+};
+
+//--------------------------------------------------------------
+// The depth codec on its own, for anything else that wants it.
+
+namespace DepthCodec {
+    void encode(const unsigned short* depth, int width, int height, vector<unsigned char>& out);
+    bool decode(const unsigned char* in, size_t bytes, int width, int height, unsigned short* depth);
+}
@@ -0,0 +1,90 @@
+#include "KinectSource.h"
+
+//--------------------------------------------------------------
+float KinectSource::getWorldScale(){
+    
+    // Projection is linear in both offset and depth, so one probe is enough
+    float depth = 1000;
+    return getWorldCoordinateAt(getWidth() / 2 + 1.0f, getHeight() / 2.0f, depth).x / depth;
+}
+
+
+
+
+
+//--------------------------------------------------------------
+LiveKinectSource::LiveKinectSource()
+: bInitialised(false), bDepthNew(false), bVideoNew(false), bFrameNew(false){
+}
+
+//--------------------------------------------------------------
+bool LiveKinectSource::open(){
+    if (!bInitialised){
+        kinect.setRegistration(true);
+        kinect.init(false, true, false);
+        bInitialised = true;
+    }
+    return kinect.open();
+}
+
+//--------------------------------------------------------------
+void LiveKinectSource::close(){
+    kinect.close();
+}
+
+//--------------------------------------------------------------
+void LiveKinectSource::update(){
+    kinect.update();
+    
+    // Depth and video come in on their own, and each only refills its own
+    // buffers. A frame's new once both have, or a swapped out buffer would
+    // come back round with an old frame in it.
+    if (kinect.isFrameNewDepth()) bDepthNew = true;
+    if (kinect.isFrameNewVideo()) bVideoNew = true;
+    bFrameNew = bDepthNew && bVideoNew;
+    if (bFrameNew){
+        bDepthNew = false;
+        bVideoNew = false;
+    }
+}
+
+//--------------------------------------------------------------
+bool LiveKinectSource::isFrameNew(){
+    return bFrameNew;
+}
+
+//--------------------------------------------------------------
+ofShortPixels& LiveKinectSource::getRawDepthPixels(){
+    return kinect.getRawDepthPixels();
+}
+
+//--------------------------------------------------------------
+ofPixels& LiveKinectSource::getDepthPixels(){
+    return kinect.getDepthPixels();
+}
+
+//--------------------------------------------------------------
+ofPixels& LiveKinectSource::getPixels(){
+    return kinect.getPixels();
+}
+
+//--------------------------------------------------------------
+ofVec3f LiveKinectSource::getWorldCoordinateAt(float cx, float cy, float wz){
+    
+    // ofxKinect needs a device for its registration data
+    if (!kinect.isConnected()){
+        float factor = DEFAULT_WORLD_SCALE * wz;
+        return ofVec3f((cx - getWidth() / 2) * factor, (cy - getHeight() / 2) * factor, wz);
+    }
+    return kinect.getWorldCoordinateAt(cx, cy, wz);
+}
+
+//--------------------------------------------------------------
+void LiveKinectSource::setDepthClipping(float near, float far){
+    kinect.setDepthClipping(near, far);
+}
+
+//--------------------------------------------------------------
+void LiveKinectSource::setCameraTiltAngle(float angle){
+    kinect.setCameraTiltAngle(angle);
+}
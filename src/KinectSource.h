@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxKinect.h"
+
+// A depth + RGB frame source. It mirrors the handful of ofxKinect calls ofApp
+// relies on, so the meshing pipeline can run from the live sensor or from a
+// recorded session without knowing which one it's talking to.
+//
+// Sources aren't thread safe, only whoever calls update() should read their
+// pixels. Everyone else gets frames from the CaptureThread.
+//
+// The CaptureThread swaps its own buffers for the source's rather than
+// copying them, so a source has to fill all three from scratch on every new
+// frame, into whatever buffers it's holding at the time.
+
+class KinectSource {
+
+    public:
+        // The kinect's stock zero plane, for when there's no device to ask
+        static constexpr float DEFAULT_WORLD_SCALE = 2.0 * 0.1042 / 120.0;
+
+        virtual ~KinectSource(){}
+
+        virtual bool open() = 0;
+        virtual void close() = 0;
+        virtual void update() = 0;
+        virtual bool isFrameNew() = 0;
+
+        virtual int getWidth() const = 0;
+        virtual int getHeight() const = 0;
+
+        virtual ofShortPixels& getRawDepthPixels() = 0; // Depth in millimetres, 0 == no reading
+        virtual ofPixels& getDepthPixels() = 0;         // 8 bit depth for display, near is white
+        virtual ofPixels& getPixels() = 0;              // Registered RGB image
+
+        // Project a depth image coordinate (cx, cy) at depth wz into world space
+        virtual ofVec3f getWorldCoordinateAt(float cx, float cy, float wz) = 0;
+
+        // Hardware controls, ignored by anything that isn't a real kinect
+        virtual void setDepthClipping(float /*near*/, float /*far*/){}
+        virtual void setCameraTiltAngle(float /*angle*/){}
+
+        float getWorldScale();  // World units per pixel offset per unit of depth
+};
+
+//--------------------------------------------------------------
+// The live sensor, a thin wrapper around ofxKinect. It doesn't keep textures
+// of its own as it's updated off the GL thread.
+
+class LiveKinectSource : public KinectSource {
+
+    public:
+        LiveKinectSource();
+
+        bool open();
+        void close();
+        void update();
+        bool isFrameNew();
+
+        int getWidth() const { return ofxKinect::width; }
+        int getHeight() const { return ofxKinect::height; }
+
+        ofShortPixels& getRawDepthPixels();
+        ofPixels& getDepthPixels();
+        ofPixels& getPixels();
+
+        ofVec3f getWorldCoordinateAt(float cx, float cy, float wz);
+
+        void setDepthClipping(float near, float far);
+        void setCameraTiltAngle(float angle);
+
+    private:
+        ofxKinect kinect;
+        bool bInitialised;
+        bool bDepthNew;     // Since the last frame, the streams arrive separately
+        bool bVideoNew;
+        bool bFrameNew;
+};
@@ -0,0 +1,150 @@
+#include "MaskCoverage.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//--------------------------------------------------------------
+MaskCoverage::MaskCoverage()
+:width(0)
+,height(0){
+}
+
+//--------------------------------------------------------------
+void MaskCoverage::build(const unsigned char* mask, int width, int height){
+
+    this->width = width;
+    this->height = height;
+    int stride = width + 1;
+    table.resize(stride * (height + 1));
+
+    // table[x, y] counts the mask pixels above and to the left of (x, y)
+    memset(&table[0], 0, stride * sizeof(unsigned int));
+    for (int y = 0; y < height; y++){
+        const unsigned char* row = mask + y * width;
+        const unsigned int* above = &table[y * stride];
+        unsigned int* out = &table[(y + 1) * stride];
+        unsigned int sum = 0;
+        out[0] = 0;
+        for (int x = 0; x < width; x++){
+            sum += row[x] > 0;
+            out[x + 1] = above[x + 1] + sum;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+float MaskCoverage::getCoverage(int x0, int y0, int x1, int y1) const {
+    int stride = width + 1;
+    unsigned int inside = table[(y1 + 1) * stride + x1 + 1] - table[y0 * stride + x1 + 1]
+                        - table[(y1 + 1) * stride + x0] + table[y0 * stride + x0];
+    return inside / (float)((x1 - x0 + 1) * (y1 - y0 + 1));
+}
+
+//--------------------------------------------------------------
+void MaskCoverage::cull(const ofVec3f* corners, int count, float threshold, unsigned char* keep) const {
+    cull(corners, count, threshold, keep, DepthKernels::getBestInstructionSet());
+}
+
+//--------------------------------------------------------------
+void MaskCoverage::cull(const ofVec3f* corners, int count, float threshold, unsigned char* keep, DepthKernels::InstructionSet set) const {
+    int done = 0;
+#if defined(__SSE2__)
+    if (set >= DepthKernels::SSE2) done = cullSSE2(corners, count, threshold, keep);
+#else
+    (void)set;
+#endif
+    cullScalar(corners + done * 3, count - done, threshold, keep + done);
+}
+
+//--------------------------------------------------------------
+int MaskCoverage::cullScalar(const ofVec3f* corners, int count, float threshold, unsigned char* keep) const {
+
+    float cx = width / 2;
+    float cy = height / 2;
+    for (int i = 0; i < count; i++){
+        const ofVec3f* p = corners + i * 3;
+        float x0 = ofClamp(min(p[0].x, min(p[1].x, p[2].x)) + cx, 0, width - 1);
+        float x1 = ofClamp(max(p[0].x, max(p[1].x, p[2].x)) + cx, 0, width - 1);
+        float y0 = ofClamp(min(p[0].y, min(p[1].y, p[2].y)) + cy, 0, height - 1);
+        float y1 = ofClamp(max(p[0].y, max(p[1].y, p[2].y)) + cy, 0, height - 1);
+
+        int bx0 = x0, by0 = y0, bx1 = x1, by1 = y1;
+        int stride = width + 1;
+        int inside = table[(by1 + 1) * stride + bx1 + 1] - table[by0 * stride + bx1 + 1]
+                   - table[(by1 + 1) * stride + bx0] + table[by0 * stride + bx0];
+        int area = (bx1 - bx0 + 1) * (by1 - by0 + 1);
+        keep[i] = inside >= threshold * area;
+    }
+    return count;
+}
+
+#if defined(__SSE2__)
+//--------------------------------------------------------------
+int MaskCoverage::cullSSE2(const ofVec3f* corners, int count, float threshold, unsigned char* keep) const {
+
+    const __m128 centreX = _mm_set1_ps(width / 2);
+    const __m128 centreY = _mm_set1_ps(height / 2);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxX = _mm_set1_ps(width - 1);
+    const __m128 maxY = _mm_set1_ps(height - 1);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128 stride = _mm_set1_ps(width + 1);
+    const __m128 thresholds = _mm_set1_ps(threshold);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4){
+        const ofVec3f* p = corners + i * 3;
+
+        // Boxes of four triangles at once, a corner to a register
+        __m128 ax = _mm_setr_ps(p[0].x, p[3].x, p[6].x, p[9].x);
+        __m128 bx = _mm_setr_ps(p[1].x, p[4].x, p[7].x, p[10].x);
+        __m128 cx = _mm_setr_ps(p[2].x, p[5].x, p[8].x, p[11].x);
+        __m128 ay = _mm_setr_ps(p[0].y, p[3].y, p[6].y, p[9].y);
+        __m128 by = _mm_setr_ps(p[1].y, p[4].y, p[7].y, p[10].y);
+        __m128 cy = _mm_setr_ps(p[2].y, p[5].y, p[8].y, p[11].y);
+
+        __m128 x0 = _mm_add_ps(_mm_min_ps(ax, _mm_min_ps(bx, cx)), centreX);
+        __m128 x1 = _mm_add_ps(_mm_max_ps(ax, _mm_max_ps(bx, cx)), centreX);
+        __m128 y0 = _mm_add_ps(_mm_min_ps(ay, _mm_min_ps(by, cy)), centreY);
+        __m128 y1 = _mm_add_ps(_mm_max_ps(ay, _mm_max_ps(by, cy)), centreY);
+        x0 = _mm_min_ps(_mm_max_ps(x0, zero), maxX);
+        x1 = _mm_min_ps(_mm_max_ps(x1, zero), maxX);
+        y0 = _mm_min_ps(_mm_max_ps(y0, zero), maxY);
+        y1 = _mm_min_ps(_mm_max_ps(y1, zero), maxY);
+
+        // Truncate like the scalar path, then back to float for the table
+        // offsets, SSE2 has no 32 bit multiply and they're well within
+        // float's exact range
+        __m128i ix0 = _mm_cvttps_epi32(x0);
+        __m128i iy0 = _mm_cvttps_epi32(y0);
+        __m128i ix1 = _mm_add_epi32(_mm_cvttps_epi32(x1), one);
+        __m128i iy1 = _mm_add_epi32(_mm_cvttps_epi32(y1), one);
+        __m128 top = _mm_mul_ps(_mm_cvtepi32_ps(iy0), stride);
+        __m128 bottom = _mm_mul_ps(_mm_cvtepi32_ps(iy1), stride);
+        __m128 left = _mm_cvtepi32_ps(ix0);
+        __m128 right = _mm_cvtepi32_ps(ix1);
+
+        int tl[4], tr[4], bl[4], br[4];
+        _mm_storeu_si128((__m128i*)tl, _mm_cvttps_epi32(_mm_add_ps(top, left)));
+        _mm_storeu_si128((__m128i*)tr, _mm_cvttps_epi32(_mm_add_ps(top, right)));
+        _mm_storeu_si128((__m128i*)bl, _mm_cvttps_epi32(_mm_add_ps(bottom, left)));
+        _mm_storeu_si128((__m128i*)br, _mm_cvttps_epi32(_mm_add_ps(bottom, right)));
+
+        // The lookups themselves are a gather, there's no way round that
+        __m128i inside = _mm_setr_epi32(table[br[0]] - table[tr[0]] - table[bl[0]] + table[tl[0]],
+                                        table[br[1]] - table[tr[1]] - table[bl[1]] + table[tl[1]],
+                                        table[br[2]] - table[tr[2]] - table[bl[2]] + table[tl[2]],
+                                        table[br[3]] - table[tr[3]] - table[bl[3]] + table[tl[3]]);
+
+        __m128 area = _mm_mul_ps(_mm_sub_ps(right, left), _mm_cvtepi32_ps(_mm_sub_epi32(iy1, iy0)));
+        __m128 kept = _mm_cmpge_ps(_mm_cvtepi32_ps(inside), _mm_mul_ps(thresholds, area));
+        int bits = _mm_movemask_ps(kept);
+        keep[i] = bits & 1;
+        keep[i + 1] = (bits >> 1) & 1;
+        keep[i + 2] = (bits >> 2) & 1;
+        keep[i + 3] = (bits >> 3) & 1;
+    }
+    return i;
+}
+#endif
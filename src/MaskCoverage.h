@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthKernels.h"
+
+// Keeps or drops triangles by how much of their bounding box is on the depth
+// mask. A summed-area table of the mask is built once a frame, after which any
+// box's coverage is four lookups, however big the triangle. A single sample at
+// the centroid would miss slivers and keep triangles bridging narrow gaps.
+//
+// Triangles are tested four at a time with SSE2 where the CPU has it.
+
+class MaskCoverage {
+
+    public:
+        MaskCoverage();
+
+        void build(const unsigned char* mask, int width, int height);
+
+        // Fraction of the box's pixels on the mask, bounds inclusive
+        float getCoverage(int x0, int y0, int x1, int y1) const;
+
+        // Corners are three per triangle, centred on the image the way the
+        // meshers make them. keep[i] is 1 where at least `threshold` of
+        // triangle i's box is on the mask.
+        void cull(const ofVec3f* corners, int count, float threshold, unsigned char* keep) const;
+        void cull(const ofVec3f* corners, int count, float threshold, unsigned char* keep, DepthKernels::InstructionSet set) const;
+
+    private:
+        int cullScalar(const ofVec3f* corners, int count, float threshold, unsigned char* keep) const;
+#if defined(__SSE2__)
+        int cullSSE2(const ofVec3f* corners, int count, float threshold, unsigned char* keep) const;
+#endif
+
+        int width;
+        int height;
+        vector<unsigned int> table;     // (width + 1) x (height + 1), with a zero row and column up front
+};
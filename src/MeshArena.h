@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Owns the meshing pipeline's scratch buffers from one frame to the next.
+// Nothing in here is ever freed or shrunk, and setup() sizes everything for
+// the worst case up front, so steady state meshing doesn't touch the heap.
+//
+// The output meshes live in the MeshingThread's buffers. The mesher sizes
+// each of them for the worst case the first time it's handed it, and they're
+// only ever clear()ed after that, which keeps their capacity. ofxDelaunay is
+// the exception, it allocates its own working space on every call.
+
+struct MeshArena {
+
+    vector<ofPoint> points;         // Sampled points, in the order they go to the triangulator
+    vector<int> triangleIds;        // Triangles waiting to be culled, three vertex ids each...
+    vector<ofVec3f> corners;        // ...and their positions
+    vector<int> colorPixels;        // RGB pixel under each output vertex
+    vector<unsigned char> rgb;      // The colours gathered from them, packed
+
+    void setup(int width, int height){
+        points.reserve(width * height);
+        triangleIds.reserve(width * height * 6);  // At most two triangles a pixel
+        corners.reserve(width * height * 6);
+        colorPixels.reserve(width * height);
+        rgb.reserve(width * height * 3);
+    }
+};
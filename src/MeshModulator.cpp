@@ -0,0 +1,44 @@
+#include "MeshModulator.h"
+
+//--------------------------------------------------------------
+MeshModulator::MeshModulator()
+:pool(NULL){
+}
+
+//--------------------------------------------------------------
+void MeshModulator::setThreadPool(ThreadPool* pool){
+    this->pool = pool;
+}
+
+//--------------------------------------------------------------
+void MeshModulator::modulate(const ofVec3f* rest, ofVec3f* out, int count, const NoiseKernels::Displacement& displacement,
+                             const NoiseVolume* volume, float phase){
+
+    if (count <= 0) return;
+
+    // Every vertex looks up the same phase, blend it once up front
+    if (volume != NULL) volume->getSlice(phase, slice);
+
+    // Find the first output vertex on a cache line boundary. From there every
+    // CHUNK_VERTICES lands on another one, and the first chunk also takes
+    // whatever comes before it.
+    int first = 0;
+    uintptr_t address = (uintptr_t)out;
+    while (first < 16 && (address + first * sizeof(ofVec3f)) % CACHE_LINE != 0) first++;
+    if (first == 16) first = 0;     // Not even 4 byte aligned, chunk it anyway
+
+    int numChunks = max(1, (count - first + CHUNK_VERTICES - 1) / CHUNK_VERTICES);
+
+    // Each chunk copies its rest positions over and displaces them while
+    // they're still in cache
+    auto job = [&](int chunk){
+        int begin = chunk == 0 ? 0 : first + chunk * CHUNK_VERTICES;
+        int end = min(count, first + (chunk + 1) * CHUNK_VERTICES);
+        if (end <= begin) return;
+        if (out != rest) memcpy(&out[begin], &rest[begin], (end - begin) * sizeof(ofVec3f));
+        if (volume != NULL) volume->displace(slice, &out[begin].x, end - begin, displacement.amount);
+        else NoiseKernels::displace(&out[begin].x, end - begin, displacement);
+    };
+    if (pool != NULL && numChunks > 1) pool->parallelFor(numChunks, job);
+    else for (int i = 0; i < numChunks; i++) job(i);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofMain.h"
+#include "NoiseKernels.h"
+#include "NoiseVolume.h"
+#include "ThreadPool.h"
+
+// Displaces the mesh's vertices with the looping noise, split across a thread
+// pool. Every vertex is displaced on its own, so the vertex buffer is cut into
+// chunks that each thread writes straight into.
+//
+// Chunks start on 64 byte cache lines. A vertex is 12 bytes, so that's every
+// 16 vertices, and no two threads ever write to the same line.
+//
+// The displaced positions are worked out from the rest positions the mesher
+// built every time, never from last frame's, so the noise doesn't pile up.
+// The loop moves on every frame, so every frame displaces the lot.
+//
+// Given a baked NoiseVolume for the displacement's parameters, the noise is
+// looked up in that instead of being worked out.
+
+class MeshModulator {
+
+    public:
+        MeshModulator();
+
+        void setThreadPool(ThreadPool* pool);   // NULL to displace on the calling thread
+
+        // out[i] = rest[i] displaced, for count vertices. With a volume, phase
+        // is how far round the loop the displacement's loop terms are.
+        void modulate(const ofVec3f* rest, ofVec3f* out, int count, const NoiseKernels::Displacement& displacement,
+                      const NoiseVolume* volume = NULL, float phase = 0);
+
+    private:
+        static const int CACHE_LINE = 64;
+        static const int CHUNK_VERTICES = 1024;    // A multiple of the 16 vertices in 3 cache lines
+
+        ThreadPool* pool;
+
+        vector<float> slice;        // The volume at this frame's phase
+};
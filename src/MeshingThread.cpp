@@ -0,0 +1,114 @@
+#include "MeshingThread.h"
+
+//--------------------------------------------------------------
+MeshingThread::MeshingThread()
+:bThreaded(true)
+,bInputReady(false)
+,lastMillis(0)
+,bMeshNew(false){
+}
+
+//--------------------------------------------------------------
+MeshingThread::~MeshingThread(){
+    stop();
+}
+
+//--------------------------------------------------------------
+void MeshingThread::setup(ThreadPool* pool, bool threaded){
+
+    mesher.setThreadPool(pool);
+
+    bThreaded = threaded;
+    if (bThreaded) startThread();
+}
+
+//--------------------------------------------------------------
+void MeshingThread::stop(){
+    if (isThreadRunning()){
+        {
+            std::unique_lock<std::mutex> lock(inputMutex);
+            stopThread();
+        }
+        inputCondition.notify_one();
+        waitForThread(false);
+    }
+}
+
+//--------------------------------------------------------------
+bool MeshingThread::submit(shared_ptr<const KinectFrame> frame, const MeshSettings& settings){
+
+    if (bInputReady || frame == NULL || !frame->rawDepth.isAllocated()) return false;
+
+    input = frame;
+    this->settings = settings;
+    {
+        std::unique_lock<std::mutex> lock(inputMutex);
+        bInputReady = true;
+    }
+    inputCondition.notify_one();
+    return true;
+}
+
+//--------------------------------------------------------------
+void MeshingThread::update(){
+    if (!bThreaded && bInputReady) build();
+    bMeshNew = outputs.consume();
+}
+
+//--------------------------------------------------------------
+MeshOutput& MeshingThread::getOutput(){
+    return outputs.getFront();
+}
+
+//--------------------------------------------------------------
+bool MeshingThread::isMeshNew() const {
+    return bMeshNew;
+}
+
+//--------------------------------------------------------------
+float MeshingThread::getLastMillis() const {
+    return lastMillis;
+}
+
+//--------------------------------------------------------------
+void MeshingThread::reportBench(){
+    std::unique_lock<std::mutex> lock(benchMutex);
+    mesher.getBench().report();
+}
+
+//--------------------------------------------------------------
+void MeshingThread::resetBench(){
+    std::unique_lock<std::mutex> lock(benchMutex);
+    mesher.getBench().reset();
+}
+
+//--------------------------------------------------------------
+int MeshingThread::getAllocatingBuilds(){
+    std::unique_lock<std::mutex> lock(benchMutex);
+    return mesher.getAllocatingBuilds();
+}
+
+//--------------------------------------------------------------
+void MeshingThread::threadedFunction(){
+    while (isThreadRunning()){
+        {
+            std::unique_lock<std::mutex> lock(inputMutex);
+            inputCondition.wait(lock, [this]{ return bInputReady || !isThreadRunning(); });
+        }
+        if (bInputReady) build();
+    }
+}
+
+//--------------------------------------------------------------
+void MeshingThread::build(){
+    {
+        std::unique_lock<std::mutex> lock(benchMutex);
+        mesher.build(*input, settings, outputs.getBack());
+        lastMillis = mesher.getBench().getLastMillis("updateDelaunay");
+    }
+    outputs.publish();
+    input.reset();      // The capture thread can have the frame back
+
+    // Ready for the next frame
+    bInputReady = false;
+}
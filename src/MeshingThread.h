@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ofMain.h"
+#include "KinectFrame.h"
+#include "TripleBuffer.h"
+#include "DelaunayMesher.h"
+#include "ThreadPool.h"
+
+// Builds the delaunay mesh on its own thread. The render loop offers it
+// frames along with how to mesh them, and keeps drawing and modulating the
+// last mesh it picked up until a newer one is published. Frames offered
+// while it's busy are turned down.
+//
+// Meshes are built straight into the back slot of a triple buffer, and
+// picking up a new one is an atomic swap of slot indices, so the render loop
+// never copies a mesh or waits for one.
+//
+// Like the CaptureThread it can run synchronously instead, for deterministic
+// replays.
+
+class MeshingThread : public ofThread {
+
+    public:
+        MeshingThread();
+        ~MeshingThread();
+
+        void setup(ThreadPool* pool, bool threaded = true);
+        void stop();
+
+        // Holds on to the frame until it's been meshed, nothing's copied.
+        // False, and a cheap no-op, if it's still busy with the last one.
+        bool submit(shared_ptr<const KinectFrame> frame, const MeshSettings& settings);
+        void update();                  // Call once per frame from the render loop
+
+        // The newest mesh. It stays put until the next update(), and the
+        // render loop is free to modify it until then.
+        MeshOutput& getOutput();
+        bool isMeshNew() const;
+
+        float getLastMillis() const;    // How long the last build took
+
+        // The mesher's stage timings, safe to call while it's building
+        void reportBench();
+        void resetBench();
+        int getAllocatingBuilds();      // See DelaunayMesher
+
+    private:
+        void threadedFunction();
+        void build();
+
+        DelaunayMesher mesher;
+        bool bThreaded;
+
+        // The frame being meshed. Only written while bInputReady is false,
+        // only read by the mesher while it's true, and let go once it's done.
+        shared_ptr<const KinectFrame> input;
+        MeshSettings settings;
+        std::atomic<bool> bInputReady;
+        std::mutex inputMutex;
+        std::condition_variable inputCondition;
+
+        std::mutex benchMutex;
+        std::atomic<float> lastMillis;
+
+        TripleBuffer<MeshOutput> outputs;
+        bool bMeshNew;
+};
@@ -0,0 +1,707 @@
+#include "NoiseKernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_TARGET
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+    // Skewing and unskewing factors for 4D, exactly as ofNoise has them
+    const float F4 = 0.309016994f;  // (sqrt(5) - 1) / 4
+    const float G4 = 0.138196601f;  // (5 - sqrt(5)) / 20
+    const float RADIUS = 0.6f;      // Each corner's reach, squared
+    const float SCALE = 27.0f;      // Brings the sum to about -1 to 1
+
+    // Ken Perlin's permutation, twice over so lookups never need wrapping
+    const int PERM[512] = {
+        151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
+        140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148,
+        247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32,
+        57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175,
+        74, 165, 71, 134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122,
+        60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54,
+        65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169,
+        200, 196, 135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64,
+        52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212,
+        207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+        119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+        129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104,
+        218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241,
+        81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157,
+        184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93,
+        222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180,
+        151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
+        140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148,
+        247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32,
+        57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175,
+        74, 165, 71, 134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122,
+        60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54,
+        65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169,
+        200, 196, 135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64,
+        52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212,
+        207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+        119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+        129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104,
+        218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241,
+        81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157,
+        184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93,
+        222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
+    };
+
+    // Rounds 0 and negative integers down a whole step, like ofNoise's
+    // FASTFLOOR. It has to, to land in the same cells.
+    inline int fastFloor(float x){
+        return x > 0 ? (int)x : (int)x - 1;
+    }
+
+    // One of 32 gradient directions, dotted with the offset
+    inline float grad4(int hash, float x, float y, float z, float t){
+        int h = hash & 31;
+        float u = h < 24 ? x : y;
+        float v = h < 16 ? y : z;
+        float w = h < 8 ? z : t;
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v) + ((h & 4) ? -w : w);
+    }
+
+    inline float corner(int hash, float x, float y, float z, float w){
+        float t = RADIUS - x * x - y * y - z * z - w * w;
+        if (t < 0.0f) return 0.0f;
+        t *= t;
+        return t * t * grad4(hash, x, y, z, w);
+    }
+
+    // The five lattice corners' hashes, from the cell's wrapped coordinates
+    // and the offsets of the second to fourth corners
+    inline void hashCorners(int ii, int jj, int kk, int ll, int i1, int j1, int k1, int l1,
+                            int i2, int j2, int k2, int l2, int i3, int j3, int k3, int l3, int* hashes){
+        hashes[0] = PERM[ii + PERM[jj + PERM[kk + PERM[ll]]]];
+        hashes[1] = PERM[ii + i1 + PERM[jj + j1 + PERM[kk + k1 + PERM[ll + l1]]]];
+        hashes[2] = PERM[ii + i2 + PERM[jj + j2 + PERM[kk + k2 + PERM[ll + l2]]]];
+        hashes[3] = PERM[ii + i3 + PERM[jj + j3 + PERM[kk + k3 + PERM[ll + l3]]]];
+        hashes[4] = PERM[ii + 1 + PERM[jj + 1 + PERM[kk + 1 + PERM[ll + 1]]]];
+    }
+
+    float noiseScalar(float x, float y, float z, float w){
+
+        // Which cell of 24 simplices the point is in
+        float s = (x + y + z + w) * F4;
+        int i = fastFloor(x + s);
+        int j = fastFloor(y + s);
+        int k = fastFloor(z + s);
+        int l = fastFloor(w + s);
+
+        float t = (i + j + k + l) * G4;
+        float x0 = x - (i - t);
+        float y0 = y - (j - t);
+        float z0 = z - (k - t);
+        float w0 = w - (l - t);
+
+        // Which simplex in the cell, from the order of the offsets. Ranking
+        // them is the same as ofNoise's lookup table, ties and all.
+        int rankX = 0, rankY = 0, rankZ = 0, rankW = 0;
+        if (x0 > y0) rankX++; else rankY++;
+        if (x0 > z0) rankX++; else rankZ++;
+        if (x0 > w0) rankX++; else rankW++;
+        if (y0 > z0) rankY++; else rankZ++;
+        if (y0 > w0) rankY++; else rankW++;
+        if (z0 > w0) rankZ++; else rankW++;
+
+        int i1 = rankX >= 3, j1 = rankY >= 3, k1 = rankZ >= 3, l1 = rankW >= 3;
+        int i2 = rankX >= 2, j2 = rankY >= 2, k2 = rankZ >= 2, l2 = rankW >= 2;
+        int i3 = rankX >= 1, j3 = rankY >= 1, k3 = rankZ >= 1, l3 = rankW >= 1;
+
+        int hashes[5];
+        hashCorners(i & 0xff, j & 0xff, k & 0xff, l & 0xff, i1, j1, k1, l1, i2, j2, k2, l2, i3, j3, k3, l3, hashes);
+
+        float n0 = corner(hashes[0], x0, y0, z0, w0);
+        float n1 = corner(hashes[1], x0 - i1 + G4, y0 - j1 + G4, z0 - k1 + G4, w0 - l1 + G4);
+        float n2 = corner(hashes[2], x0 - i2 + 2.0f * G4, y0 - j2 + 2.0f * G4, z0 - k2 + 2.0f * G4, w0 - l2 + 2.0f * G4);
+        float n3 = corner(hashes[3], x0 - i3 + 3.0f * G4, y0 - j3 + 3.0f * G4, z0 - k3 + 3.0f * G4, w0 - l3 + 3.0f * G4);
+        float n4 = corner(hashes[4], x0 - 1.0f + 4.0f * G4, y0 - 1.0f + 4.0f * G4, z0 - 1.0f + 4.0f * G4, w0 - 1.0f + 4.0f * G4);
+        return SCALE * (n0 + n1 + n2 + n3 + n4);
+    }
+
+    // ofMap(n, -1, 1, -amount, amount), step for step
+    inline float mapScalar(float n, float amount){
+        return (n + 1.0f) / 2.0f * (amount + amount) - amount;
+    }
+
+    void displaceScalar(float* xyz, int count, const NoiseKernels::Displacement& d){
+        for (int i = 0; i < count; i++){
+            float* p = xyz + i * 3;
+            if (d.bXZ){
+                p[0] += mapScalar(noiseScalar(d.scale * p[0], d.scale * p[2], d.loopZ, d.loopW), d.amount);
+                p[1] += mapScalar(noiseScalar(d.scale * p[1], d.scale * p[2], d.loopZ, d.loopW), d.amount);
+            }
+            else {
+                // y's noise is looked up from the x that's already been moved
+                p[0] += mapScalar(noiseScalar(d.scale * p[0], d.scale * p[1], d.loopZ, d.loopW), d.amount);
+                p[1] += mapScalar(noiseScalar(d.scale * p[0], d.scale * p[1], d.loopZ, d.loopW), d.amount);
+            }
+        }
+    }
+
+#if defined(__SSE2__)
+    // SSE2 has no blend, select with masks
+    inline __m128 selectSSE2(__m128i mask, __m128 a, __m128 b){
+        __m128 m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+
+    inline __m128 cornerSSE2(__m128i hash, __m128 x, __m128 y, __m128 z, __m128 w){
+        __m128 t = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(RADIUS), _mm_mul_ps(x, x)),
+                                                    _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+        __m128 inside = _mm_cmpge_ps(t, _mm_setzero_ps());
+        t = _mm_mul_ps(t, t);
+
+        __m128i h = _mm_and_si128(hash, _mm_set1_epi32(31));
+        __m128 u = selectSSE2(_mm_cmplt_epi32(h, _mm_set1_epi32(24)), x, y);
+        __m128 v = selectSSE2(_mm_cmplt_epi32(h, _mm_set1_epi32(16)), y, z);
+        __m128 s = selectSSE2(_mm_cmplt_epi32(h, _mm_set1_epi32(8)), z, w);
+
+        // Negate by flipping the sign bit where the hash's low bits say so
+        u = _mm_xor_ps(u, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31)));
+        v = _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30)));
+        s = _mm_xor_ps(s, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), 29)));
+        __m128 grad = _mm_add_ps(_mm_add_ps(u, v), s);
+
+        return _mm_and_ps(inside, _mm_mul_ps(_mm_mul_ps(t, t), grad));
+    }
+
+    __m128 noiseSSE2(__m128 x, __m128 y, __m128 z, __m128 w){
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i one = _mm_set1_epi32(1);
+
+        __m128 s = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(x, y), z), w), _mm_set1_ps(F4));
+        __m128 xs = _mm_add_ps(x, s);
+        __m128 ys = _mm_add_ps(y, s);
+        __m128 zs = _mm_add_ps(z, s);
+        __m128 ws = _mm_add_ps(w, s);
+
+        // Truncate, then a step down wherever it isn't above 0
+        __m128i i = _mm_add_epi32(_mm_cvttps_epi32(xs), _mm_castps_si128(_mm_cmpngt_ps(xs, zero)));
+        __m128i j = _mm_add_epi32(_mm_cvttps_epi32(ys), _mm_castps_si128(_mm_cmpngt_ps(ys, zero)));
+        __m128i k = _mm_add_epi32(_mm_cvttps_epi32(zs), _mm_castps_si128(_mm_cmpngt_ps(zs, zero)));
+        __m128i l = _mm_add_epi32(_mm_cvttps_epi32(ws), _mm_castps_si128(_mm_cmpngt_ps(ws, zero)));
+
+        __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32(i, j), k), l)), _mm_set1_ps(G4));
+        __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+        __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+        __m128 z0 = _mm_sub_ps(z, _mm_sub_ps(_mm_cvtepi32_ps(k), t));
+        __m128 w0 = _mm_sub_ps(w, _mm_sub_ps(_mm_cvtepi32_ps(l), t));
+
+        // Comparisons are all ones where true, so subtracting them counts
+        __m128i xy = _mm_castps_si128(_mm_cmpgt_ps(x0, y0));
+        __m128i xz = _mm_castps_si128(_mm_cmpgt_ps(x0, z0));
+        __m128i xw = _mm_castps_si128(_mm_cmpgt_ps(x0, w0));
+        __m128i yz = _mm_castps_si128(_mm_cmpgt_ps(y0, z0));
+        __m128i yw = _mm_castps_si128(_mm_cmpgt_ps(y0, w0));
+        __m128i zw = _mm_castps_si128(_mm_cmpgt_ps(z0, w0));
+        __m128i rankX = _mm_sub_epi32(_mm_setzero_si128(), _mm_add_epi32(_mm_add_epi32(xy, xz), xw));
+        __m128i rankY = _mm_sub_epi32(_mm_add_epi32(one, xy), _mm_add_epi32(yz, yw));
+        __m128i rankZ = _mm_sub_epi32(_mm_add_epi32(_mm_set1_epi32(2), _mm_add_epi32(xz, yz)), zw);
+        __m128i rankW = _mm_add_epi32(_mm_set1_epi32(3), _mm_add_epi32(_mm_add_epi32(xw, yw), zw));
+
+        // The hashes are chains of dependent table lookups, done a lane at a time
+        int ranks[4][4];
+        int cells[4][4];
+        _mm_storeu_si128((__m128i*)ranks[0], rankX);
+        _mm_storeu_si128((__m128i*)ranks[1], rankY);
+        _mm_storeu_si128((__m128i*)ranks[2], rankZ);
+        _mm_storeu_si128((__m128i*)ranks[3], rankW);
+        _mm_storeu_si128((__m128i*)cells[0], i);
+        _mm_storeu_si128((__m128i*)cells[1], j);
+        _mm_storeu_si128((__m128i*)cells[2], k);
+        _mm_storeu_si128((__m128i*)cells[3], l);
+        int hashes[5][4];
+        for (int lane = 0; lane < 4; lane++){
+            int rx = ranks[0][lane], ry = ranks[1][lane], rz = ranks[2][lane], rw = ranks[3][lane];
+            int h[5];
+            hashCorners(cells[0][lane] & 0xff, cells[1][lane] & 0xff, cells[2][lane] & 0xff, cells[3][lane] & 0xff,
+                        rx >= 3, ry >= 3, rz >= 3, rw >= 3, rx >= 2, ry >= 2, rz >= 2, rw >= 2,
+                        rx >= 1, ry >= 1, rz >= 1, rw >= 1, h);
+            for (int c = 0; c < 5; c++) hashes[c][lane] = h[c];
+        }
+
+        // Corner offsets, 1 where a corner steps along that axis
+        __m128 i1 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankX, _mm_set1_epi32(2)), one));
+        __m128 j1 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankY, _mm_set1_epi32(2)), one));
+        __m128 k1 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankZ, _mm_set1_epi32(2)), one));
+        __m128 l1 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankW, _mm_set1_epi32(2)), one));
+        __m128 i2 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankX, one), one));
+        __m128 j2 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankY, one), one));
+        __m128 k2 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankZ, one), one));
+        __m128 l2 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankW, one), one));
+        __m128 i3 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankX, _mm_setzero_si128()), one));
+        __m128 j3 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankY, _mm_setzero_si128()), one));
+        __m128 k3 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankZ, _mm_setzero_si128()), one));
+        __m128 l3 = _mm_cvtepi32_ps(_mm_and_si128(_mm_cmpgt_epi32(rankW, _mm_setzero_si128()), one));
+
+        const __m128 g1 = _mm_set1_ps(G4);
+        const __m128 g2 = _mm_set1_ps(2.0f * G4);
+        const __m128 g3 = _mm_set1_ps(3.0f * G4);
+        const __m128 g4 = _mm_set1_ps(4.0f * G4);
+        const __m128 unit = _mm_set1_ps(1.0f);
+
+        __m128 n0 = cornerSSE2(_mm_loadu_si128((const __m128i*)hashes[0]), x0, y0, z0, w0);
+        __m128 n1 = cornerSSE2(_mm_loadu_si128((const __m128i*)hashes[1]),
+                               _mm_add_ps(_mm_sub_ps(x0, i1), g1), _mm_add_ps(_mm_sub_ps(y0, j1), g1),
+                               _mm_add_ps(_mm_sub_ps(z0, k1), g1), _mm_add_ps(_mm_sub_ps(w0, l1), g1));
+        __m128 n2 = cornerSSE2(_mm_loadu_si128((const __m128i*)hashes[2]),
+                               _mm_add_ps(_mm_sub_ps(x0, i2), g2), _mm_add_ps(_mm_sub_ps(y0, j2), g2),
+                               _mm_add_ps(_mm_sub_ps(z0, k2), g2), _mm_add_ps(_mm_sub_ps(w0, l2), g2));
+        __m128 n3 = cornerSSE2(_mm_loadu_si128((const __m128i*)hashes[3]),
+                               _mm_add_ps(_mm_sub_ps(x0, i3), g3), _mm_add_ps(_mm_sub_ps(y0, j3), g3),
+                               _mm_add_ps(_mm_sub_ps(z0, k3), g3), _mm_add_ps(_mm_sub_ps(w0, l3), g3));
+        __m128 n4 = cornerSSE2(_mm_loadu_si128((const __m128i*)hashes[4]),
+                               _mm_add_ps(_mm_sub_ps(x0, unit), g4), _mm_add_ps(_mm_sub_ps(y0, unit), g4),
+                               _mm_add_ps(_mm_sub_ps(z0, unit), g4), _mm_add_ps(_mm_sub_ps(w0, unit), g4));
+
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(n0, n1), n2), n3), n4);
+        return _mm_mul_ps(_mm_set1_ps(SCALE), sum);
+    }
+
+    inline __m128 mapSSE2(__m128 n, __m128 amount){
+        __m128 half = _mm_mul_ps(_mm_add_ps(n, _mm_set1_ps(1.0f)), _mm_set1_ps(0.5f));
+        return _mm_sub_ps(_mm_mul_ps(half, _mm_add_ps(amount, amount)), amount);
+    }
+
+    int signedNoiseSSE2(const float* x, const float* y, float z, float w, int count, float* out){
+        const __m128 zs = _mm_set1_ps(z);
+        const __m128 ws = _mm_set1_ps(w);
+        int i = 0;
+        for (; i + 4 <= count; i += 4){
+            _mm_storeu_ps(out + i, noiseSSE2(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i), zs, ws));
+        }
+        return i;
+    }
+
+    // Four vertices at a time, a component to a register
+    int displaceSSE2(float* xyz, int count, const NoiseKernels::Displacement& d){
+        const __m128 scale = _mm_set1_ps(d.scale);
+        const __m128 amount = _mm_set1_ps(d.amount);
+        const __m128 loopZ = _mm_set1_ps(d.loopZ);
+        const __m128 loopW = _mm_set1_ps(d.loopW);
+
+        int i = 0;
+        for (; i + 4 <= count; i += 4){
+            float* p = xyz + i * 3;
+            __m128 x = _mm_setr_ps(p[0], p[3], p[6], p[9]);
+            __m128 y = _mm_setr_ps(p[1], p[4], p[7], p[10]);
+            __m128 z = _mm_setr_ps(p[2], p[5], p[8], p[11]);
+
+            if (d.bXZ){
+                __m128 dx = mapSSE2(noiseSSE2(_mm_mul_ps(scale, x), _mm_mul_ps(scale, z), loopZ, loopW), amount);
+                __m128 dy = mapSSE2(noiseSSE2(_mm_mul_ps(scale, y), _mm_mul_ps(scale, z), loopZ, loopW), amount);
+                x = _mm_add_ps(x, dx);
+                y = _mm_add_ps(y, dy);
+            }
+            else {
+                x = _mm_add_ps(x, mapSSE2(noiseSSE2(_mm_mul_ps(scale, x), _mm_mul_ps(scale, y), loopZ, loopW), amount));
+                y = _mm_add_ps(y, mapSSE2(noiseSSE2(_mm_mul_ps(scale, x), _mm_mul_ps(scale, y), loopZ, loopW), amount));
+            }
+
+            float xs[4], ys[4];
+            _mm_storeu_ps(xs, x);
+            _mm_storeu_ps(ys, y);
+            for (int v = 0; v < 4; v++){
+                p[v * 3] = xs[v];
+                p[v * 3 + 1] = ys[v];
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(__ARM_NEON)
+    // The SSE2 version a register at a time, NEON has its own select. The
+    // multiplies and adds are kept apart rather than written as vfmaq, so
+    // they round the same as the scalar version.
+    inline float32x4_t cornerNEON(int32x4_t hash, float32x4_t x, float32x4_t y, float32x4_t z, float32x4_t w){
+        float32x4_t t = vsubq_f32(vsubq_f32(vsubq_f32(vsubq_f32(vdupq_n_f32(RADIUS), vmulq_f32(x, x)),
+                                                      vmulq_f32(y, y)), vmulq_f32(z, z)), vmulq_f32(w, w));
+        uint32x4_t inside = vcgeq_f32(t, vdupq_n_f32(0.0f));
+        t = vmulq_f32(t, t);
+
+        int32x4_t h = vandq_s32(hash, vdupq_n_s32(31));
+        float32x4_t u = vbslq_f32(vcltq_s32(h, vdupq_n_s32(24)), x, y);
+        float32x4_t v = vbslq_f32(vcltq_s32(h, vdupq_n_s32(16)), y, z);
+        float32x4_t s = vbslq_f32(vcltq_s32(h, vdupq_n_s32(8)), z, w);
+
+        u = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(u),
+                                            vreinterpretq_u32_s32(vshlq_n_s32(vandq_s32(h, vdupq_n_s32(1)), 31))));
+        v = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v),
+                                            vreinterpretq_u32_s32(vshlq_n_s32(vandq_s32(h, vdupq_n_s32(2)), 30))));
+        s = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(s),
+                                            vreinterpretq_u32_s32(vshlq_n_s32(vandq_s32(h, vdupq_n_s32(4)), 29))));
+        float32x4_t grad = vaddq_f32(vaddq_f32(u, v), s);
+
+        return vreinterpretq_f32_u32(vandq_u32(inside, vreinterpretq_u32_f32(vmulq_f32(vmulq_f32(t, t), grad))));
+    }
+
+    // Comparisons are all ones where true, -1 as a signed lane
+    inline int32x4_t countNEON(uint32x4_t mask){
+        return vreinterpretq_s32_u32(mask);
+    }
+
+    // 1 where a rank is above the bar, 0 where it isn't
+    inline float32x4_t stepNEON(int32x4_t rank, int bar){
+        return vcvtq_f32_s32(vandq_s32(countNEON(vcgtq_s32(rank, vdupq_n_s32(bar))), vdupq_n_s32(1)));
+    }
+
+    float32x4_t noiseNEON(float32x4_t x, float32x4_t y, float32x4_t z, float32x4_t w){
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const int32x4_t one = vdupq_n_s32(1);
+
+        float32x4_t s = vmulq_f32(vaddq_f32(vaddq_f32(vaddq_f32(x, y), z), w), vdupq_n_f32(F4));
+        float32x4_t xs = vaddq_f32(x, s);
+        float32x4_t ys = vaddq_f32(y, s);
+        float32x4_t zs = vaddq_f32(z, s);
+        float32x4_t ws = vaddq_f32(w, s);
+
+        // Truncate, then a step down wherever it isn't above 0
+        int32x4_t i = vaddq_s32(vcvtq_s32_f32(xs), countNEON(vcleq_f32(xs, zero)));
+        int32x4_t j = vaddq_s32(vcvtq_s32_f32(ys), countNEON(vcleq_f32(ys, zero)));
+        int32x4_t k = vaddq_s32(vcvtq_s32_f32(zs), countNEON(vcleq_f32(zs, zero)));
+        int32x4_t l = vaddq_s32(vcvtq_s32_f32(ws), countNEON(vcleq_f32(ws, zero)));
+
+        float32x4_t t = vmulq_f32(vcvtq_f32_s32(vaddq_s32(vaddq_s32(vaddq_s32(i, j), k), l)), vdupq_n_f32(G4));
+        float32x4_t x0 = vsubq_f32(x, vsubq_f32(vcvtq_f32_s32(i), t));
+        float32x4_t y0 = vsubq_f32(y, vsubq_f32(vcvtq_f32_s32(j), t));
+        float32x4_t z0 = vsubq_f32(z, vsubq_f32(vcvtq_f32_s32(k), t));
+        float32x4_t w0 = vsubq_f32(w, vsubq_f32(vcvtq_f32_s32(l), t));
+
+        int32x4_t xy = countNEON(vcgtq_f32(x0, y0));
+        int32x4_t xz = countNEON(vcgtq_f32(x0, z0));
+        int32x4_t xw = countNEON(vcgtq_f32(x0, w0));
+        int32x4_t yz = countNEON(vcgtq_f32(y0, z0));
+        int32x4_t yw = countNEON(vcgtq_f32(y0, w0));
+        int32x4_t zw = countNEON(vcgtq_f32(z0, w0));
+        int32x4_t rankX = vsubq_s32(vdupq_n_s32(0), vaddq_s32(vaddq_s32(xy, xz), xw));
+        int32x4_t rankY = vsubq_s32(vaddq_s32(one, xy), vaddq_s32(yz, yw));
+        int32x4_t rankZ = vsubq_s32(vaddq_s32(vdupq_n_s32(2), vaddq_s32(xz, yz)), zw);
+        int32x4_t rankW = vaddq_s32(vdupq_n_s32(3), vaddq_s32(vaddq_s32(xw, yw), zw));
+
+        // No gathers, so the hashes are looked up a lane at a time like SSE2's
+        int ranks[4][4];
+        int cells[4][4];
+        vst1q_s32(ranks[0], rankX);
+        vst1q_s32(ranks[1], rankY);
+        vst1q_s32(ranks[2], rankZ);
+        vst1q_s32(ranks[3], rankW);
+        vst1q_s32(cells[0], i);
+        vst1q_s32(cells[1], j);
+        vst1q_s32(cells[2], k);
+        vst1q_s32(cells[3], l);
+        int hashes[5][4];
+        for (int lane = 0; lane < 4; lane++){
+            int rx = ranks[0][lane], ry = ranks[1][lane], rz = ranks[2][lane], rw = ranks[3][lane];
+            int h[5];
+            hashCorners(cells[0][lane] & 0xff, cells[1][lane] & 0xff, cells[2][lane] & 0xff, cells[3][lane] & 0xff,
+                        rx >= 3, ry >= 3, rz >= 3, rw >= 3, rx >= 2, ry >= 2, rz >= 2, rw >= 2,
+                        rx >= 1, ry >= 1, rz >= 1, rw >= 1, h);
+            for (int c = 0; c < 5; c++) hashes[c][lane] = h[c];
+        }
+
+        const float32x4_t g1 = vdupq_n_f32(G4);
+        const float32x4_t g2 = vdupq_n_f32(2.0f * G4);
+        const float32x4_t g3 = vdupq_n_f32(3.0f * G4);
+        const float32x4_t g4 = vdupq_n_f32(4.0f * G4);
+        const float32x4_t unit = vdupq_n_f32(1.0f);
+
+        float32x4_t n0 = cornerNEON(vld1q_s32(hashes[0]), x0, y0, z0, w0);
+        float32x4_t n1 = cornerNEON(vld1q_s32(hashes[1]),
+                                    vaddq_f32(vsubq_f32(x0, stepNEON(rankX, 2)), g1), vaddq_f32(vsubq_f32(y0, stepNEON(rankY, 2)), g1),
+                                    vaddq_f32(vsubq_f32(z0, stepNEON(rankZ, 2)), g1), vaddq_f32(vsubq_f32(w0, stepNEON(rankW, 2)), g1));
+        float32x4_t n2 = cornerNEON(vld1q_s32(hashes[2]),
+                                    vaddq_f32(vsubq_f32(x0, stepNEON(rankX, 1)), g2), vaddq_f32(vsubq_f32(y0, stepNEON(rankY, 1)), g2),
+                                    vaddq_f32(vsubq_f32(z0, stepNEON(rankZ, 1)), g2), vaddq_f32(vsubq_f32(w0, stepNEON(rankW, 1)), g2));
+        float32x4_t n3 = cornerNEON(vld1q_s32(hashes[3]),
+                                    vaddq_f32(vsubq_f32(x0, stepNEON(rankX, 0)), g3), vaddq_f32(vsubq_f32(y0, stepNEON(rankY, 0)), g3),
+                                    vaddq_f32(vsubq_f32(z0, stepNEON(rankZ, 0)), g3), vaddq_f32(vsubq_f32(w0, stepNEON(rankW, 0)), g3));
+        float32x4_t n4 = cornerNEON(vld1q_s32(hashes[4]),
+                                    vaddq_f32(vsubq_f32(x0, unit), g4), vaddq_f32(vsubq_f32(y0, unit), g4),
+                                    vaddq_f32(vsubq_f32(z0, unit), g4), vaddq_f32(vsubq_f32(w0, unit), g4));
+
+        float32x4_t sum = vaddq_f32(vaddq_f32(vaddq_f32(vaddq_f32(n0, n1), n2), n3), n4);
+        return vmulq_f32(vdupq_n_f32(SCALE), sum);
+    }
+
+    inline float32x4_t mapNEON(float32x4_t n, float32x4_t amount){
+        float32x4_t half = vmulq_f32(vaddq_f32(n, vdupq_n_f32(1.0f)), vdupq_n_f32(0.5f));
+        return vsubq_f32(vmulq_f32(half, vaddq_f32(amount, amount)), amount);
+    }
+
+    int signedNoiseNEON(const float* x, const float* y, float z, float w, int count, float* out){
+        const float32x4_t zs = vdupq_n_f32(z);
+        const float32x4_t ws = vdupq_n_f32(w);
+        int i = 0;
+        for (; i + 4 <= count; i += 4){
+            vst1q_f32(out + i, noiseNEON(vld1q_f32(x + i), vld1q_f32(y + i), zs, ws));
+        }
+        return i;
+    }
+
+    // Four vertices at a time, the loads and stores pull the components
+    // apart and put them back together on their own
+    int displaceNEON(float* xyz, int count, const NoiseKernels::Displacement& d){
+        const float32x4_t scale = vdupq_n_f32(d.scale);
+        const float32x4_t amount = vdupq_n_f32(d.amount);
+        const float32x4_t loopZ = vdupq_n_f32(d.loopZ);
+        const float32x4_t loopW = vdupq_n_f32(d.loopW);
+
+        int i = 0;
+        for (; i + 4 <= count; i += 4){
+            float* p = xyz + i * 3;
+            float32x4x3_t v = vld3q_f32(p);
+            float32x4_t x = v.val[0];
+            float32x4_t y = v.val[1];
+            float32x4_t z = v.val[2];
+
+            if (d.bXZ){
+                float32x4_t dx = mapNEON(noiseNEON(vmulq_f32(scale, x), vmulq_f32(scale, z), loopZ, loopW), amount);
+                float32x4_t dy = mapNEON(noiseNEON(vmulq_f32(scale, y), vmulq_f32(scale, z), loopZ, loopW), amount);
+                x = vaddq_f32(x, dx);
+                y = vaddq_f32(y, dy);
+            }
+            else {
+                x = vaddq_f32(x, mapNEON(noiseNEON(vmulq_f32(scale, x), vmulq_f32(scale, y), loopZ, loopW), amount));
+                y = vaddq_f32(y, mapNEON(noiseNEON(vmulq_f32(scale, x), vmulq_f32(scale, y), loopZ, loopW), amount));
+            }
+
+            v.val[0] = x;
+            v.val[1] = y;
+            vst3q_f32(p, v);
+        }
+        return i;
+    }
+#endif
+
+#ifdef HAVE_AVX2_TARGET
+    __attribute__((target("avx2")))
+    inline __m256 cornerAVX2(__m256i hash, __m256 x, __m256 y, __m256 z, __m256 w){
+        __m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(RADIUS), _mm256_mul_ps(x, x)),
+                                                             _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)), _mm256_mul_ps(w, w));
+        __m256 inside = _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ);
+        t = _mm256_mul_ps(t, t);
+
+        __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(31));
+        __m256 u = _mm256_blendv_ps(y, x, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(24), h)));
+        __m256 v = _mm256_blendv_ps(z, y, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(16), h)));
+        __m256 s = _mm256_blendv_ps(w, z, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h)));
+
+        u = _mm256_xor_ps(u, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31)));
+        v = _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30)));
+        s = _mm256_xor_ps(s, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(4)), 29)));
+        __m256 grad = _mm256_add_ps(_mm256_add_ps(u, v), s);
+
+        return _mm256_and_ps(inside, _mm256_mul_ps(_mm256_mul_ps(t, t), grad));
+    }
+
+    // PERM[a + PERM[b + PERM[c + PERM[d]]]], eight lanes at a time
+    __attribute__((target("avx2")))
+    inline __m256i hashAVX2(__m256i a, __m256i b, __m256i c, __m256i d){
+        __m256i h = _mm256_i32gather_epi32(PERM, d, 4);
+        h = _mm256_i32gather_epi32(PERM, _mm256_add_epi32(c, h), 4);
+        h = _mm256_i32gather_epi32(PERM, _mm256_add_epi32(b, h), 4);
+        return _mm256_i32gather_epi32(PERM, _mm256_add_epi32(a, h), 4);
+    }
+
+    __attribute__((target("avx2")))
+    __m256 noiseAVX2(__m256 x, __m256 y, __m256 z, __m256 w){
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i wrap = _mm256_set1_epi32(0xff);
+
+        __m256 s = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), w), _mm256_set1_ps(F4));
+        __m256 xs = _mm256_add_ps(x, s);
+        __m256 ys = _mm256_add_ps(y, s);
+        __m256 zs = _mm256_add_ps(z, s);
+        __m256 ws = _mm256_add_ps(w, s);
+
+        __m256i i = _mm256_add_epi32(_mm256_cvttps_epi32(xs), _mm256_castps_si256(_mm256_cmp_ps(xs, zero, _CMP_NGT_UQ)));
+        __m256i j = _mm256_add_epi32(_mm256_cvttps_epi32(ys), _mm256_castps_si256(_mm256_cmp_ps(ys, zero, _CMP_NGT_UQ)));
+        __m256i k = _mm256_add_epi32(_mm256_cvttps_epi32(zs), _mm256_castps_si256(_mm256_cmp_ps(zs, zero, _CMP_NGT_UQ)));
+        __m256i l = _mm256_add_epi32(_mm256_cvttps_epi32(ws), _mm256_castps_si256(_mm256_cmp_ps(ws, zero, _CMP_NGT_UQ)));
+
+        __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(i, j), k), l)),
+                                 _mm256_set1_ps(G4));
+        __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(_mm256_cvtepi32_ps(i), t));
+        __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(_mm256_cvtepi32_ps(j), t));
+        __m256 z0 = _mm256_sub_ps(z, _mm256_sub_ps(_mm256_cvtepi32_ps(k), t));
+        __m256 w0 = _mm256_sub_ps(w, _mm256_sub_ps(_mm256_cvtepi32_ps(l), t));
+
+        __m256i xy = _mm256_castps_si256(_mm256_cmp_ps(x0, y0, _CMP_GT_OQ));
+        __m256i xz = _mm256_castps_si256(_mm256_cmp_ps(x0, z0, _CMP_GT_OQ));
+        __m256i xw = _mm256_castps_si256(_mm256_cmp_ps(x0, w0, _CMP_GT_OQ));
+        __m256i yz = _mm256_castps_si256(_mm256_cmp_ps(y0, z0, _CMP_GT_OQ));
+        __m256i yw = _mm256_castps_si256(_mm256_cmp_ps(y0, w0, _CMP_GT_OQ));
+        __m256i zw = _mm256_castps_si256(_mm256_cmp_ps(z0, w0, _CMP_GT_OQ));
+        __m256i rankX = _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_add_epi32(_mm256_add_epi32(xy, xz), xw));
+        __m256i rankY = _mm256_sub_epi32(_mm256_add_epi32(one, xy), _mm256_add_epi32(yz, yw));
+        __m256i rankZ = _mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(2), _mm256_add_epi32(xz, yz)), zw);
+        __m256i rankW = _mm256_add_epi32(_mm256_set1_epi32(3), _mm256_add_epi32(_mm256_add_epi32(xw, yw), zw));
+
+        __m256i i1 = _mm256_and_si256(_mm256_cmpgt_epi32(rankX, _mm256_set1_epi32(2)), one);
+        __m256i j1 = _mm256_and_si256(_mm256_cmpgt_epi32(rankY, _mm256_set1_epi32(2)), one);
+        __m256i k1 = _mm256_and_si256(_mm256_cmpgt_epi32(rankZ, _mm256_set1_epi32(2)), one);
+        __m256i l1 = _mm256_and_si256(_mm256_cmpgt_epi32(rankW, _mm256_set1_epi32(2)), one);
+        __m256i i2 = _mm256_and_si256(_mm256_cmpgt_epi32(rankX, one), one);
+        __m256i j2 = _mm256_and_si256(_mm256_cmpgt_epi32(rankY, one), one);
+        __m256i k2 = _mm256_and_si256(_mm256_cmpgt_epi32(rankZ, one), one);
+        __m256i l2 = _mm256_and_si256(_mm256_cmpgt_epi32(rankW, one), one);
+        __m256i i3 = _mm256_and_si256(_mm256_cmpgt_epi32(rankX, _mm256_setzero_si256()), one);
+        __m256i j3 = _mm256_and_si256(_mm256_cmpgt_epi32(rankY, _mm256_setzero_si256()), one);
+        __m256i k3 = _mm256_and_si256(_mm256_cmpgt_epi32(rankZ, _mm256_setzero_si256()), one);
+        __m256i l3 = _mm256_and_si256(_mm256_cmpgt_epi32(rankW, _mm256_setzero_si256()), one);
+
+        // Every lookup is a gather from the same table
+        __m256i ii = _mm256_and_si256(i, wrap);
+        __m256i jj = _mm256_and_si256(j, wrap);
+        __m256i kk = _mm256_and_si256(k, wrap);
+        __m256i ll = _mm256_and_si256(l, wrap);
+        __m256i h0 = hashAVX2(ii, jj, kk, ll);
+        __m256i h1 = hashAVX2(_mm256_add_epi32(ii, i1), _mm256_add_epi32(jj, j1), _mm256_add_epi32(kk, k1), _mm256_add_epi32(ll, l1));
+        __m256i h2 = hashAVX2(_mm256_add_epi32(ii, i2), _mm256_add_epi32(jj, j2), _mm256_add_epi32(kk, k2), _mm256_add_epi32(ll, l2));
+        __m256i h3 = hashAVX2(_mm256_add_epi32(ii, i3), _mm256_add_epi32(jj, j3), _mm256_add_epi32(kk, k3), _mm256_add_epi32(ll, l3));
+        __m256i h4 = hashAVX2(_mm256_add_epi32(ii, one), _mm256_add_epi32(jj, one), _mm256_add_epi32(kk, one), _mm256_add_epi32(ll, one));
+
+        const __m256 g1 = _mm256_set1_ps(G4);
+        const __m256 g2 = _mm256_set1_ps(2.0f * G4);
+        const __m256 g3 = _mm256_set1_ps(3.0f * G4);
+        const __m256 g4 = _mm256_set1_ps(4.0f * G4);
+        const __m256 unit = _mm256_set1_ps(1.0f);
+
+        __m256 n0 = cornerAVX2(h0, x0, y0, z0, w0);
+        __m256 n1 = cornerAVX2(h1,
+            _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i1)), g1), _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j1)), g1),
+            _mm256_add_ps(_mm256_sub_ps(z0, _mm256_cvtepi32_ps(k1)), g1), _mm256_add_ps(_mm256_sub_ps(w0, _mm256_cvtepi32_ps(l1)), g1));
+        __m256 n2 = cornerAVX2(h2,
+            _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i2)), g2), _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j2)), g2),
+            _mm256_add_ps(_mm256_sub_ps(z0, _mm256_cvtepi32_ps(k2)), g2), _mm256_add_ps(_mm256_sub_ps(w0, _mm256_cvtepi32_ps(l2)), g2));
+        __m256 n3 = cornerAVX2(h3,
+            _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i3)), g3), _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j3)), g3),
+            _mm256_add_ps(_mm256_sub_ps(z0, _mm256_cvtepi32_ps(k3)), g3), _mm256_add_ps(_mm256_sub_ps(w0, _mm256_cvtepi32_ps(l3)), g3));
+        __m256 n4 = cornerAVX2(h4,
+            _mm256_add_ps(_mm256_sub_ps(x0, unit), g4), _mm256_add_ps(_mm256_sub_ps(y0, unit), g4),
+            _mm256_add_ps(_mm256_sub_ps(z0, unit), g4), _mm256_add_ps(_mm256_sub_ps(w0, unit), g4));
+
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(n0, n1), n2), n3), n4);
+        return _mm256_mul_ps(_mm256_set1_ps(SCALE), sum);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256 mapAVX2(__m256 n, __m256 amount){
+        __m256 half = _mm256_mul_ps(_mm256_add_ps(n, _mm256_set1_ps(1.0f)), _mm256_set1_ps(0.5f));
+        return _mm256_sub_ps(_mm256_mul_ps(half, _mm256_add_ps(amount, amount)), amount);
+    }
+
+    __attribute__((target("avx2")))
+    int signedNoiseAVX2(const float* x, const float* y, float z, float w, int count, float* out){
+        const __m256 zs = _mm256_set1_ps(z);
+        const __m256 ws = _mm256_set1_ps(w);
+        int i = 0;
+        for (; i + 8 <= count; i += 8){
+            _mm256_storeu_ps(out + i, noiseAVX2(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), zs, ws));
+        }
+        return i;
+    }
+
+    // Eight vertices at a time, pulled apart into components with gathers
+    __attribute__((target("avx2")))
+    int displaceAVX2(float* xyz, int count, const NoiseKernels::Displacement& d){
+        const __m256 scale = _mm256_set1_ps(d.scale);
+        const __m256 amount = _mm256_set1_ps(d.amount);
+        const __m256 loopZ = _mm256_set1_ps(d.loopZ);
+        const __m256 loopW = _mm256_set1_ps(d.loopW);
+        const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+        int i = 0;
+        for (; i + 8 <= count; i += 8){
+            float* p = xyz + i * 3;
+            __m256 x = _mm256_i32gather_ps(p, stride, 4);
+            __m256 y = _mm256_i32gather_ps(p + 1, stride, 4);
+            __m256 z = _mm256_i32gather_ps(p + 2, stride, 4);
+
+            if (d.bXZ){
+                __m256 dx = mapAVX2(noiseAVX2(_mm256_mul_ps(scale, x), _mm256_mul_ps(scale, z), loopZ, loopW), amount);
+                __m256 dy = mapAVX2(noiseAVX2(_mm256_mul_ps(scale, y), _mm256_mul_ps(scale, z), loopZ, loopW), amount);
+                x = _mm256_add_ps(x, dx);
+                y = _mm256_add_ps(y, dy);
+            }
+            else {
+                x = _mm256_add_ps(x, mapAVX2(noiseAVX2(_mm256_mul_ps(scale, x), _mm256_mul_ps(scale, y), loopZ, loopW), amount));
+                y = _mm256_add_ps(y, mapAVX2(noiseAVX2(_mm256_mul_ps(scale, x), _mm256_mul_ps(scale, y), loopZ, loopW), amount));
+            }
+
+            float xs[8], ys[8];
+            _mm256_storeu_ps(xs, x);
+            _mm256_storeu_ps(ys, y);
+            for (int v = 0; v < 8; v++){
+                p[v * 3] = xs[v];
+                p[v * 3 + 1] = ys[v];
+            }
+        }
+        return i;
+    }
+#endif
+}
+
+//--------------------------------------------------------------
+const int* NoiseKernels::getPermutation(){
+    return PERM;
+}
+
+//--------------------------------------------------------------
+float NoiseKernels::signedNoise(float x, float y, float z, float w){
+    return noiseScalar(x, y, z, w);
+}
+
+//--------------------------------------------------------------
+void NoiseKernels::signedNoise(const float* x, const float* y, float z, float w, int count, float* out){
+    signedNoise(x, y, z, w, count, out, DepthKernels::getBestInstructionSet());
+}
+
+//--------------------------------------------------------------
+void NoiseKernels::signedNoise(const float* x, const float* y, float z, float w, int count, float* out, InstructionSet set){
+    int done = 0;
+#if defined(__ARM_NEON)
+    if (set == DepthKernels::NEON) done = signedNoiseNEON(x, y, z, w, count, out);
+#endif
+#ifdef HAVE_AVX2_TARGET
+    if (set == DepthKernels::AVX2) done = signedNoiseAVX2(x, y, z, w, count, out);
+#endif
+#if defined(__SSE2__)
+    if (set == DepthKernels::SSE2 || set == DepthKernels::AVX2) done += signedNoiseSSE2(x + done, y + done, z, w, count - done, out + done);
+#endif
+    for (int i = done; i < count; i++) out[i] = noiseScalar(x[i], y[i], z, w);
+}
+
+//--------------------------------------------------------------
+void NoiseKernels::displace(float* xyz, int count, const Displacement& displacement){
+    displace(xyz, count, displacement, DepthKernels::getBestInstructionSet());
+}
+
+//--------------------------------------------------------------
+void NoiseKernels::displace(float* xyz, int count, const Displacement& displacement, InstructionSet set){
+    int done = 0;
+#if defined(__ARM_NEON)
+    if (set == DepthKernels::NEON) done = displaceNEON(xyz, count, displacement);
+#endif
+#ifdef HAVE_AVX2_TARGET
+    if (set == DepthKernels::AVX2) done = displaceAVX2(xyz, count, displacement);
+#endif
+#if defined(__SSE2__)
+    if (set == DepthKernels::SSE2 || set == DepthKernels::AVX2) done += displaceSSE2(xyz + done * 3, count - done, displacement);
+#endif
+    displaceScalar(xyz + done * 3, count - done, displacement);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "DepthKernels.h"
+
+// Batched 4D simplex noise for displacing the mesh on the CPU. It's
+// ofSignedNoise() ported so that four (SSE2, NEON) or eight (AVX2) points go
+// through it at once, with the same arithmetic in the same order, so every
+// version comes out within a rounding error of ofSignedNoise(). The
+// versions are picked at runtime, like the depth kernels.
+
+namespace NoiseKernels {
+
+    using DepthKernels::InstructionSet;
+
+    // What modulateDelaunay() adds to each vertex. The loop terms are the
+    // same for every vertex in a frame, so they're worked out once.
+    struct Displacement {
+        float scale;        // noiseScale
+        float amount;       // noiseAmt, the most a vertex moves either way
+        float loopZ;        // noiseRadius * sin(TWO_PI * t)
+        float loopW;        // noiseRadius * cos(TWO_PI * t)
+        bool bXZ;           // bNoiseMode: (x, z) and (y, z) rather than (x, y) twice
+    };
+
+    // Ken Perlin's permutation, the 256 entries the noise hashes with. The
+    // noise shader is handed it so the GPU displaces by the same field.
+    const int* getPermutation();
+
+    // One point, the scalar reference
+    float signedNoise(float x, float y, float z, float w);
+
+    // out[i] = signedNoise(x[i], y[i], z, w)
+    void signedNoise(const float* x, const float* y, float z, float w, int count, float* out);
+    void signedNoise(const float* x, const float* y, float z, float w, int count, float* out, InstructionSet set);
+
+    // Displaces packed xyz vertices in place
+    void displace(float* xyz, int count, const Displacement& displacement);
+    void displace(float* xyz, int count, const Displacement& displacement, InstructionSet set);
+}
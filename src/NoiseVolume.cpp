@@ -0,0 +1,150 @@
+#include "NoiseVolume.h"
+
+//--------------------------------------------------------------
+bool NoiseVolume::Key::operator==(const Key& key) const {
+    return scale == key.scale
+        && radius == key.radius
+        && bXZ == key.bXZ
+        && width == key.width
+        && height == key.height
+        && depthFar == key.depthFar
+        && amount == key.amount;
+}
+
+//--------------------------------------------------------------
+bool NoiseVolume::isBakeable(const Key& key){
+    int nu, nv, nPhases;
+    getSize(key, nu, nv, nPhases);
+    return (int64_t)nu * nv * nPhases <= MAX_SAMPLES;
+}
+
+//--------------------------------------------------------------
+void NoiseVolume::getBounds(const Key& key, float& uMin, float& uMax, float& vMin, float& vMax){
+
+    // (x, z) and (y, z) share a plane, one axis across the image and one
+    // into it...
+    if (key.bXZ){
+        uMax = key.scale * max(key.width, key.height) / 2;
+        uMin = -uMax;
+        vMin = -key.scale * key.depthFar;
+        vMax = 0;
+    }
+
+    // ...and (x, y) looks y's noise up from the x it's just moved
+    else {
+        uMax = key.scale * (key.width / 2 + key.amount);
+        uMin = -uMax;
+        vMax = key.scale * key.height / 2;
+        vMin = -vMax;
+    }
+}
+
+//--------------------------------------------------------------
+void NoiseVolume::getSize(const Key& key, int& nu, int& nv, int& nPhases){
+    float uMin, uMax, vMin, vMax;
+    getBounds(key, uMin, uMax, vMin, vMax);
+    nu = max(2, (int)ceil((uMax - uMin) * SAMPLES_PER_UNIT) + 1);
+    nv = max(2, (int)ceil((vMax - vMin) * SAMPLES_PER_UNIT) + 1);
+    nPhases = max(MIN_PHASES, (int)ceil(TWO_PI * key.radius * SAMPLES_PER_UNIT));
+}
+
+//--------------------------------------------------------------
+NoiseVolume::NoiseVolume()
+:nu(0)
+,nv(0)
+,nPhases(0)
+,uMin(0)
+,vMin(0)
+,uScale(0)
+,vScale(0){
+    key = Key();
+}
+
+//--------------------------------------------------------------
+void NoiseVolume::build(const Key& key){
+
+    this->key = key;
+    float uMax, vMax;
+    getBounds(key, uMin, uMax, vMin, vMax);
+    getSize(key, nu, nv, nPhases);
+    float uStep = (uMax - uMin) / (nu - 1);
+    float vStep = (vMax - vMin) / (nv - 1);
+    uScale = uStep > 0 ? 1 / uStep : 0;
+    vScale = vStep > 0 ? 1 / vStep : 0;
+
+    // A row at a time, every sample on a row shares its v and its loop terms
+    samples.resize(nu * nv * nPhases);
+    vector<float> us(nu), vs(nu);
+    for (int u = 0; u < nu; u++) us[u] = uMin + u * uStep;
+    for (int p = 0; p < nPhases; p++){
+        float phase = p / (float)nPhases;
+        float loopZ = key.radius * sin(TWO_PI * phase);
+        float loopW = key.radius * cos(TWO_PI * phase);
+        for (int v = 0; v < nv; v++){
+            std::fill(vs.begin(), vs.end(), vMin + v * vStep);
+            NoiseKernels::signedNoise(&us[0], &vs[0], loopZ, loopW, nu, &samples[(p * nv + v) * nu]);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+const NoiseVolume::Key& NoiseVolume::getKey() const {
+    return key;
+}
+
+//--------------------------------------------------------------
+int NoiseVolume::getNumSamples() const {
+    return samples.size();
+}
+
+//--------------------------------------------------------------
+void NoiseVolume::getSlice(float phase, vector<float>& slice) const {
+
+    // The loop wraps, the last step blends back into the first
+    float f = (phase - floor(phase)) * nPhases;
+    int p0 = min((int)f, nPhases - 1);
+    int p1 = (p0 + 1) % nPhases;
+    float a = f - p0;
+
+    int size = nu * nv;
+    slice.resize(size);
+    const float* s0 = &samples[p0 * size];
+    const float* s1 = &samples[p1 * size];
+    for (int i = 0; i < size; i++){
+        slice[i] = s0[i] + (s1[i] - s0[i]) * a;
+    }
+}
+
+//--------------------------------------------------------------
+float NoiseVolume::lookup(const vector<float>& slice, float u, float v) const {
+
+    // Anything past the edges gets the edge
+    float fu = min(max((u - uMin) * uScale, 0.0f), nu - 1.0f);
+    float fv = min(max((v - vMin) * vScale, 0.0f), nv - 1.0f);
+    int iu = min((int)fu, nu - 2);
+    int iv = min((int)fv, nv - 2);
+    float au = fu - iu;
+    float av = fv - iv;
+
+    const float* row0 = &slice[iv * nu + iu];
+    const float* row1 = row0 + nu;
+    float n0 = row0[0] + (row0[1] - row0[0]) * au;
+    float n1 = row1[0] + (row1[1] - row1[0]) * au;
+    return n0 + (n1 - n0) * av;
+}
+
+//--------------------------------------------------------------
+void NoiseVolume::displace(const vector<float>& slice, float* xyz, int count, float amount) const {
+    float scale = key.scale;
+    for (int i = 0; i < count; i++){
+        float* p = xyz + i * 3;
+        if (key.bXZ){
+            p[0] += amount * lookup(slice, scale * p[0], scale * p[2]);
+            p[1] += amount * lookup(slice, scale * p[1], scale * p[2]);
+        }
+        else {
+            p[0] += amount * lookup(slice, scale * p[0], scale * p[1]);
+            p[1] += amount * lookup(slice, scale * p[0], scale * p[1]);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofMain.h"
+#include "NoiseKernels.h"
+
+// The looping noise modulateDelaunay() displaces by, baked into a grid. The
+// loop terms go round a circle of noiseRadius once every loop, so for a given
+// noiseScale and noiseRadius each lookup is a function of the vertex's two
+// scaled coordinates and how far round the loop it is. That's sampled over
+// everything the vertices can reach and every step round the loop, and looked
+// up trilinearly instead of running the 4D noise per vertex.
+//
+// The phase is the same for every vertex in a frame, so each frame first
+// blends the two slices either side of it into one (u, v) plane and the
+// vertices are looked up bilinearly in that.
+
+class NoiseVolume {
+
+    public:
+        // What a volume is baked for: the noise parameters theDirector()
+        // picks, and how far the vertices can reach
+        struct Key {
+            float scale;        // noiseScale
+            float radius;       // noiseRadius
+            bool bXZ;           // bNoiseMode
+            float width;        // Depth image size, vertices are centred on it
+            float height;
+            float depthFar;     // Vertices are at most this deep
+            float amount;       // noiseAmt, how far x moves before y's lookup in (x, y) mode
+
+            bool operator==(const Key& key) const;
+        };
+
+        // Whether a volume for key would fit in MAX_SAMPLES. Scales pushed
+        // up by hand can make the noise too fine to bake.
+        static bool isBakeable(const Key& key);
+
+        NoiseVolume();
+
+        void build(const Key& key);
+        const Key& getKey() const;
+        int getNumSamples() const;
+
+        // The (u, v) plane at phase 0-1 round the loop
+        void getSlice(float phase, vector<float>& slice) const;
+
+        // Displaces packed xyz vertices in place, looking the noise up in a
+        // slice instead of working it out
+        void displace(const vector<float>& slice, float* xyz, int count, float amount) const;
+
+    private:
+        static const int SAMPLES_PER_UNIT = 8;      // Grid samples per unit of noise space
+        static const int MIN_PHASES = 32;       // Steps round the loop, however small it is
+        static const int MAX_SAMPLES = 1 << 22;     // 16MB of floats
+
+        static void getBounds(const Key& key, float& uMin, float& uMax, float& vMin, float& vMax);
+        static void getSize(const Key& key, int& nu, int& nv, int& nPhases);
+        float lookup(const vector<float>& slice, float u, float v) const;
+
+        Key key;
+        int nu, nv, nPhases;
+        float uMin, vMin;
+        float uScale, vScale;       // Noise units to grid samples
+        vector<float> samples;      // [phase][v][u]
+};
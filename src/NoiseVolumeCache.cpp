@@ -0,0 +1,97 @@
+#include "NoiseVolumeCache.h"
+
+//--------------------------------------------------------------
+NoiseVolumeCache::NoiseVolumeCache()
+:bThreaded(true)
+,bPending(false)
+,bBaking(false){
+}
+
+//--------------------------------------------------------------
+NoiseVolumeCache::~NoiseVolumeCache(){
+    stop();
+}
+
+//--------------------------------------------------------------
+void NoiseVolumeCache::setup(bool threaded){
+    bThreaded = threaded;
+    if (bThreaded) startThread();
+}
+
+//--------------------------------------------------------------
+void NoiseVolumeCache::stop(){
+    if (isThreadRunning()){
+        {
+            std::unique_lock<std::mutex> lock(volumesMutex);
+            stopThread();
+        }
+        requestCondition.notify_one();
+        waitForThread(false);
+    }
+}
+
+//--------------------------------------------------------------
+void NoiseVolumeCache::request(const NoiseVolume::Key& key){
+
+    if (!NoiseVolume::isBakeable(key)) return;
+    {
+        std::unique_lock<std::mutex> lock(volumesMutex);
+        for (auto it = volumes.begin(); it != volumes.end(); ++it){
+            if ((*it)->getKey() == key) return;
+        }
+        if ((bBaking && baking == key) || (bPending && pending == key)) return;
+
+        if (bThreaded){
+            pending = key;
+            bPending = true;
+        }
+    }
+
+    if (bThreaded) requestCondition.notify_one();
+    else bake(key);
+}
+
+//--------------------------------------------------------------
+shared_ptr<const NoiseVolume> NoiseVolumeCache::get(const NoiseVolume::Key& key){
+    std::unique_lock<std::mutex> lock(volumesMutex);
+    for (auto it = volumes.begin(); it != volumes.end(); ++it){
+        if ((*it)->getKey() == key){
+            volumes.splice(volumes.begin(), volumes, it);
+            return volumes.front();
+        }
+    }
+    return shared_ptr<const NoiseVolume>();
+}
+
+//--------------------------------------------------------------
+void NoiseVolumeCache::threadedFunction(){
+    while (isThreadRunning()){
+        NoiseVolume::Key key;
+        {
+            std::unique_lock<std::mutex> lock(volumesMutex);
+            requestCondition.wait(lock, [this]{ return bPending || !isThreadRunning(); });
+            if (!bPending) continue;
+            key = pending;
+            bPending = false;
+            baking = key;
+            bBaking = true;
+        }
+        bake(key);
+    }
+}
+
+//--------------------------------------------------------------
+void NoiseVolumeCache::bake(const NoiseVolume::Key& key){
+
+    // Baked outside the lock, the render loop keeps getting the volumes it has
+    uint64_t start = ofGetElapsedTimeMicros();
+    shared_ptr<NoiseVolume> volume = make_shared<NoiseVolume>();
+    volume->build(key);
+    ofLogVerbose("NoiseVolumeCache") << "baked " << volume->getNumSamples() << " samples in "
+                                     << ofToString((ofGetElapsedTimeMicros() - start) / 1000.0, 1) << " ms";
+
+    std::unique_lock<std::mutex> lock(volumesMutex);
+    volumes.push_front(volume);
+    while (volumes.size() > CAPACITY) volumes.pop_back();
+    bBaking = false;
+}
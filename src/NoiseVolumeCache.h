@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+#include "NoiseVolume.h"
+#include <list>
+
+// Bakes noise volumes on its own thread and keeps the last few, so going back
+// to a scene's parameters doesn't mean baking them again. theDirector()
+// requests a volume as it picks a scene, and until it's baked the render loop
+// carries on working the noise out directly.
+//
+// Volumes are handed out as shared pointers, so one being drawn with stays
+// alive when it's evicted. Like the other threads it can run synchronously
+// instead, for deterministic replays, in which case request() bakes there and
+// then.
+
+class NoiseVolumeCache : public ofThread {
+
+    public:
+        NoiseVolumeCache();
+        ~NoiseVolumeCache();
+
+        void setup(bool threaded = true);
+        void stop();
+
+        // Bakes it unless it's cached, already on its way or too big to bake.
+        // A newer request replaces one that hasn't started yet.
+        void request(const NoiseVolume::Key& key);
+
+        // NULL until it's baked
+        shared_ptr<const NoiseVolume> get(const NoiseVolume::Key& key);
+
+    private:
+        void threadedFunction();
+        void bake(const NoiseVolume::Key& key);
+
+        static const int CAPACITY = 4;
+
+        bool bThreaded;
+
+        std::mutex volumesMutex;
+        std::condition_variable requestCondition;
+        NoiseVolume::Key pending;
+        bool bPending;
+        NoiseVolume::Key baking;
+        bool bBaking;
+
+        list<shared_ptr<NoiseVolume> > volumes;   // Most recently used first
+};
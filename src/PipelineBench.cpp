@@ -0,0 +1,127 @@
+#include "PipelineBench.h"
+#include "AllocationCounter.h"
+
+// FNV-1a, cheap and good enough to tell two runs apart
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t bytes){
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; i++){
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+//--------------------------------------------------------------
+PipelineBench::PipelineBench(){
+    stages.reserve(16);
+    reset();
+}
+
+//--------------------------------------------------------------
+PipelineBench::Stage* PipelineBench::find(const char* stage){
+    for (size_t i = 0; i < stages.size(); i++){
+        if (strcmp(stages[i].name, stage) == 0) return &stages[i];
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------
+const PipelineBench::Stage* PipelineBench::find(const char* stage) const {
+    return const_cast<PipelineBench*>(this)->find(stage);
+}
+
+//--------------------------------------------------------------
+void PipelineBench::begin(const char* stage){
+    Stage* s = find(stage);
+    if (s == NULL){
+        Stage added = { stage, 0, 0, 0, 0, 0, 0, 0, 0 };
+        stages.push_back(added);
+        s = &stages.back();
+    }
+    s->allocationsAtStart = AllocationCounter::getThreadCount();
+    s->started = ofGetElapsedTimeMicros();
+}
+
+//--------------------------------------------------------------
+void PipelineBench::end(const char* stage){
+    uint64_t now = ofGetElapsedTimeMicros();
+    Stage* s = find(stage);
+    if (s == NULL) return;
+
+    uint64_t elapsed = now - s->started;
+    s->total += elapsed;
+    s->worst = std::max(s->worst, elapsed);
+    s->last = elapsed;
+    s->lastAllocations = AllocationCounter::getThreadCount() - s->allocationsAtStart;
+    s->allocations += s->lastAllocations;
+    s->count++;
+}
+
+//--------------------------------------------------------------
+void PipelineBench::addFrame(){
+    numFrames++;
+}
+
+//--------------------------------------------------------------
+void PipelineBench::addToChecksum(const ofMesh& mesh){
+    const vector<ofVec3f>& verts = mesh.getVertices();
+    uint64_t n = verts.size();
+    checksum = fnv1a(checksum, &n, sizeof(n));
+    if (n > 0) checksum = fnv1a(checksum, &verts[0], n * sizeof(ofVec3f));
+}
+
+//--------------------------------------------------------------
+int PipelineBench::getNumFrames() const {
+    return numFrames;
+}
+
+//--------------------------------------------------------------
+uint64_t PipelineBench::getChecksum() const {
+    return checksum;
+}
+
+//--------------------------------------------------------------
+double PipelineBench::getMeanMillis(const char* stage) const {
+    const Stage* s = find(stage);
+    if (s == NULL || s->count == 0) return 0;
+    return s->total / 1000.0 / s->count;
+}
+
+//--------------------------------------------------------------
+double PipelineBench::getLastMillis(const char* stage) const {
+    const Stage* s = find(stage);
+    return s == NULL ? 0 : s->last / 1000.0;
+}
+
+//--------------------------------------------------------------
+uint64_t PipelineBench::getLastAllocations(const char* stage) const {
+    const Stage* s = find(stage);
+    return s == NULL ? 0 : s->lastAllocations;
+}
+
+//--------------------------------------------------------------
+void PipelineBench::report() const {
+    ofLogNotice("PipelineBench") << numFrames << " frames";
+    for (size_t i = 0; i < stages.size(); i++){
+        const Stage& s = stages[i];
+        ofLogNotice("PipelineBench") << s.name << ": "
+            << ofToString(getMeanMillis(s.name), 3) << " ms mean, "
+            << ofToString(s.worst / 1000.0, 3) << " ms worst, "
+            << ofToString(s.count > 0 ? s.allocations / (double)s.count : 0, 1) << " allocations/call over "
+            << s.count << " calls";
+    }
+    if (!AllocationCounter::isEnabled()){
+        ofLogNotice("PipelineBench") << "(allocation counter disabled, define CAPGRAS_ALLOCATION_COUNTER to count and check them)";
+    }
+    ofLogNotice("PipelineBench") << "checksum: " << ofToString(checksum);
+}
+
+//--------------------------------------------------------------
+void PipelineBench::reset(){
+    stages.clear();
+    numFrames = 0;
+    checksum = FNV_OFFSET;
+}
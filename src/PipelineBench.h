@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Per-stage timings and heap allocations, and a running checksum of the
+// pipeline's output, so a replayed session can be profiled and compared run
+// against run. Stages are named by string literals and looked up without
+// allocating, so timing a stage doesn't disturb its allocation count.
+
+class PipelineBench {
+
+    public:
+        PipelineBench();
+
+        void begin(const char* stage);
+        void end(const char* stage);
+
+        void addFrame();
+        void addToChecksum(const ofMesh& mesh);
+
+        int getNumFrames() const;
+        uint64_t getChecksum() const;
+        double getMeanMillis(const char* stage) const;
+        double getLastMillis(const char* stage) const;
+        uint64_t getLastAllocations(const char* stage) const;  // Heap allocations during the stage's last run
+
+        void report() const;
+        void reset();
+
+    private:
+        struct Stage {
+            const char* name;
+            uint64_t started;
+            uint64_t total;
+            uint64_t worst;
+            uint64_t last;
+            uint64_t allocationsAtStart;
+            uint64_t allocations;
+            uint64_t lastAllocations;
+            int count;
+        };
+
+        Stage* find(const char* stage);
+        const Stage* find(const char* stage) const;
+
+        vector<Stage> stages;   // In the order they were first seen
+        int numFrames;
+        uint64_t checksum;
+};
@@ -0,0 +1,176 @@
+#include "ReplayKinectSource.h"
+
+//--------------------------------------------------------------
+ReplayKinectSource::ReplayKinectSource(const string& path, ReplayRate rate, float fixedFps)
+: path(path), rate(rate), fixedFps(fixedFps), bLoop(true),
+  width(0), height(0), worldScale(DEFAULT_WORLD_SCALE),
+  nearClipping(500), farClipping(4000),
+  frameIndex(-1), playbackStart(0),
+  bFrameNew(false), bFinished(false){
+}
+
+//--------------------------------------------------------------
+bool ReplayKinectSource::open(){
+
+    bFinished = false;
+    if (!recording.open(path)) return false;
+
+    width = recording.getWidth();
+    height = recording.getHeight();
+    worldScale = recording.getWorldScale();
+    if (worldScale <= 0) worldScale = DEFAULT_WORLD_SCALE;
+
+    rawDepthPixels.allocate(width, height, 1);
+    depthPixels.allocate(width, height, 1);
+    colorPixels.allocate(width, height, 3);
+
+    ofLogNotice("ReplayKinectSource") << "replaying " << recording.getNumFrames() << " frames from " << path;
+
+    rewind();
+    return true;
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::close(){
+    recording.close();
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::update(){
+
+    bFrameNew = false;
+    if (!recording.isOpen() || bFinished) return;
+
+    int due = getDueFrame();
+
+    // Out of frames, either go round again or stop here
+    if (due >= recording.getNumFrames()){
+        if (!bLoop){
+            bFinished = true;
+            return;
+        }
+        rewind();
+        due = 0;
+    }
+
+    // Frames we've fallen behind on are skipped outright, the index lets us
+    // decode just the one that's due.
+    if (due != frameIndex){
+        frameIndex = due;
+        bFrameNew = recording.readFrame(frameIndex, rawDepthPixels, colorPixels);
+        if (bFrameNew) updateDepthImage();
+
+        // Have the next couple of frames paged in before we need them
+        recording.prefetch(frameIndex + 1);
+        recording.prefetch(frameIndex + 2);
+    }
+}
+
+//--------------------------------------------------------------
+int ReplayKinectSource::getDueFrame(){
+
+    if (rate == REPLAY_MAX) return frameIndex + 1;
+
+    uint64_t elapsed = ofGetElapsedTimeMicros() - playbackStart;
+    if (rate == REPLAY_FIXED) return elapsed * fixedFps / 1000000.0;
+
+    int numFrames = recording.getNumFrames();
+    int due = std::max(frameIndex, 0);
+    while (due + 1 < numFrames && recording.getTimestamp(due + 1) <= elapsed) due++;
+
+    // Hold the last frame for as long as the one before it was shown
+    if (due == numFrames - 1 && frameIndex == due){
+        uint64_t last = recording.getTimestamp(due);
+        uint64_t period = due > 0 ? last - recording.getTimestamp(due - 1) : 33333;
+        if (elapsed > last + period) due = numFrames;
+    }
+    return due;
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::seek(int frame){
+
+    frame = ofClamp(frame, 0, recording.getNumFrames() - 1);
+    bFinished = false;
+
+    // Shift the clock so that frame is due right now
+    uint64_t offset = rate == REPLAY_FIXED ? frame * 1000000.0 / fixedFps : recording.getTimestamp(frame);
+    playbackStart = ofGetElapsedTimeMicros() - offset;
+    frameIndex = frame - 1;
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::rewind(){
+    frameIndex = -1;
+    playbackStart = ofGetElapsedTimeMicros();
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::updateDepthImage(){
+
+    // Same mapping ofxKinect uses for its 8 bit depth image
+    const unsigned short* raw = rawDepthPixels.getData();
+    unsigned char* depth = depthPixels.getData();
+    int n = width * height;
+
+    for (int i = 0; i < n; i++){
+        depth[i] = raw[i] == 0 ? 0 : ofMap(raw[i], nearClipping, farClipping, 255, 0, true);
+    }
+}
+
+//--------------------------------------------------------------
+bool ReplayKinectSource::isFrameNew(){
+    return bFrameNew;
+}
+
+//--------------------------------------------------------------
+ofShortPixels& ReplayKinectSource::getRawDepthPixels(){
+    return rawDepthPixels;
+}
+
+//--------------------------------------------------------------
+ofPixels& ReplayKinectSource::getDepthPixels(){
+    return depthPixels;
+}
+
+//--------------------------------------------------------------
+ofPixels& ReplayKinectSource::getPixels(){
+    return colorPixels;
+}
+
+//--------------------------------------------------------------
+ofVec3f ReplayKinectSource::getWorldCoordinateAt(float cx, float cy, float wz){
+    float factor = worldScale * wz;
+    return ofVec3f((cx - width / 2) * factor, (cy - height / 2) * factor, wz);
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::setDepthClipping(float near, float far){
+    nearClipping = near;
+    farClipping = far;
+}
+
+//--------------------------------------------------------------
+void ReplayKinectSource::setLoop(bool loop){
+    bLoop = loop;
+}
+
+//--------------------------------------------------------------
+bool ReplayKinectSource::isFinished() const {
+    return bFinished;
+}
+
+//--------------------------------------------------------------
+int ReplayKinectSource::getFrameIndex() const {
+    return frameIndex;
+}
+
+//--------------------------------------------------------------
+int ReplayKinectSource::getNumFrames() const {
+    return recording.getNumFrames();
+}
+
+//--------------------------------------------------------------
+bool ReplayKinectSource::isDeterministic() const {
+    return rate == REPLAY_MAX;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "KinectSource.h"
+#include "KinectRecording.h"
+
+// Plays a recorded kinect session back from disk. See KinectRecording.h for
+// the file format.
+
+enum ReplayRate {
+    REPLAY_NATIVE,  // Follow the recorded timestamps
+    REPLAY_FIXED,   // Advance at a fixed frame rate
+    REPLAY_MAX      // A new frame on every update(), independent of the clock
+};
+
+class ReplayKinectSource : public KinectSource {
+
+    public:
+        ReplayKinectSource(const string& path, ReplayRate rate = REPLAY_NATIVE, float fixedFps = 30);
+
+        bool open();
+        void close();
+        void update();
+        bool isFrameNew();
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+
+        ofShortPixels& getRawDepthPixels();
+        ofPixels& getDepthPixels();
+        ofPixels& getPixels();
+
+        ofVec3f getWorldCoordinateAt(float cx, float cy, float wz);
+
+        void setDepthClipping(float near, float far);
+
+        void setLoop(bool loop);
+        bool isFinished() const;        // Only ever true when not looping
+        int getFrameIndex() const;      // Index of the frame currently held
+        int getNumFrames() const;
+        bool isDeterministic() const;   // Same frames on every run, regardless of timing
+
+        void seek(int frame);           // Jump straight to a frame, playback carries on from there
+
+    private:
+        int getDueFrame();
+        void rewind();
+        void updateDepthImage();
+
+        string path;
+        ReplayRate rate;
+        float fixedFps;
+        bool bLoop;
+
+        KinectRecording recording;
+
+        int width;
+        int height;
+        float worldScale;
+        float nearClipping;
+        float farClipping;
+
+        ofShortPixels rawDepthPixels;
+        ofPixels depthPixels;
+        ofPixels colorPixels;
+
+        int frameIndex;
+        uint64_t playbackStart;     // Wall clock at the first frame, in micros
+        bool bFrameNew;
+        bool bFinished;
+};
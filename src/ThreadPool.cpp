@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+
+//--------------------------------------------------------------
+ThreadPool::ThreadPool()
+:invoker(NULL)
+,job(NULL)
+,count(0)
+,next(0)
+,busy(0)
+,generation(0)
+,bStopping(false){
+}
+
+//--------------------------------------------------------------
+ThreadPool::~ThreadPool(){
+    stop();
+}
+
+//--------------------------------------------------------------
+void ThreadPool::setup(int numThreads){
+
+    stop();
+
+    if (numThreads <= 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    bStopping = false;
+    for (int i = 1; i < numThreads; i++){
+        workers.push_back(std::thread(&ThreadPool::work, this));
+    }
+}
+
+//--------------------------------------------------------------
+void ThreadPool::stop(){
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        bStopping = true;
+    }
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++){
+        workers[i].join();
+    }
+    workers.clear();
+}
+
+//--------------------------------------------------------------
+int ThreadPool::getNumThreads() const {
+    return workers.size() + 1;
+}
+
+//--------------------------------------------------------------
+void ThreadPool::run(int count, void (*invoker)(void*, int), void* job){
+
+    // Not worth waking anyone for
+    if (workers.empty() || count <= 1){
+        for (int i = 0; i < count; i++) invoker(job, i);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        this->invoker = invoker;
+        this->job = job;
+        this->count = count;
+        next = 0;
+        busy = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (busy > 0) done.wait(lock);
+}
+
+//--------------------------------------------------------------
+void ThreadPool::runJobs(){
+    for (int i = next++; i < count; i = next++){
+        invoker(job, i);
+    }
+}
+
+//--------------------------------------------------------------
+void ThreadPool::work(){
+
+    unsigned seen = 0;
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!bStopping && generation == seen) wake.wait(lock);
+            if (bStopping) return;
+            seen = generation;
+        }
+
+        runJobs();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (--busy == 0) done.notify_one();
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting one job over every core. The
+// caller hands parallelFor() a count and a function of the index, joins in
+// itself, and gets control back once every index has run. Indices are handed
+// out one at a time, so uneven jobs balance themselves.
+//
+// parallelFor() doesn't allocate, the job is only ever referred to, so it's
+// safe to use from code that has to stay off the heap. It isn't reentrant:
+// one parallelFor() at a time per pool.
+
+class ThreadPool {
+
+    public:
+        ThreadPool();
+        ~ThreadPool();
+
+        void setup(int numThreads = 0);     // Including the caller, 0 == one per core
+        void stop();
+
+        int getNumThreads() const;          // Including the caller
+
+        template<typename F>
+        void parallelFor(int count, F& job){
+            run(count, &invoke<F>, &job);
+        }
+
+    private:
+        template<typename F>
+        static void invoke(void* job, int index){
+            (*(F*)job)(index);
+        }
+
+        void run(int count, void (*invoker)(void*, int), void* job);
+        void runJobs();
+        void work();
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        void (*invoker)(void*, int);
+        void* job;
+        int count;
+        std::atomic<int> next;
+        int busy;                   // Workers still on the current job
+        unsigned generation;        // Bumped for every job, so workers can tell a new one from a spurious wakeup
+        bool bStopping;
+};
@@ -0,0 +1,321 @@
+#include "TiledDelaunay.h"
+
+//--------------------------------------------------------------
+TiledDelaunay::TiledDelaunay()
+:width(0)
+,height(0)
+,spacing(0)
+,samplesX(0)
+,samplesY(0)
+,changeThreshold(8)
+,tilesX(0)
+,tilesY(0)
+,numRebuilt(0)
+,pool(NULL){
+}
+
+//--------------------------------------------------------------
+void TiledDelaunay::setThreadPool(ThreadPool* pool){
+    this->pool = pool;
+}
+
+//--------------------------------------------------------------
+void TiledDelaunay::setup(int width, int height, int spacing){
+
+    this->width = width;
+    this->height = height;
+    this->spacing = spacing;
+    samplesX = (width + spacing - 1) / spacing;
+    samplesY = (height + spacing - 1) / spacing;
+
+    int numSamples = samplesX * samplesY;
+    depths.assign(numSamples, 0);
+    positions.assign(numSamples, ofVec3f());
+
+    // Tiles overlap by one sample, the edge they share
+    tilesX = max(1, (samplesX - 1 + TILE_SAMPLES - 1) / TILE_SAMPLES);
+    tilesY = max(1, (samplesY - 1 + TILE_SAMPLES - 1) / TILE_SAMPLES);
+
+    tiles.clear();
+    tiles.resize(tilesX * tilesY);
+    for (int ty = 0; ty < tilesY; ty++){
+        for (int tx = 0; tx < tilesX; tx++){
+            Tile& tile = tiles[tx + ty * tilesX];
+            tile.x0 = tx * TILE_SAMPLES;
+            tile.y0 = ty * TILE_SAMPLES;
+            tile.x1 = min(tile.x0 + TILE_SAMPLES, samplesX - 1);
+            tile.y1 = min(tile.y0 + TILE_SAMPLES, samplesY - 1);
+            tile.reference.assign((tile.x1 - tile.x0 + 1) * (tile.y1 - tile.y0 + 1), 0);
+            tile.points.reserve(tile.reference.size());
+            tile.lattice.reserve(tile.reference.size());
+            tile.fans.reserve(tile.reference.size());
+            tile.samples.reserve(tile.reference.size());
+            tile.bBuilt = false;
+        }
+    }
+    rebuilding.reserve(tiles.size());
+
+    fans.assign(numSamples, 0);
+    seamVertex.assign(numSamples, -1);
+    seamSamples.reserve(numSamples);
+    seamLattice.reserve(numSamples);
+    seamIndices.reserve(numSamples * 6);
+}
+
+//--------------------------------------------------------------
+int TiledDelaunay::update(const KinectFrame& frame, const unsigned char* mask, int spacing, float near, float far){
+
+    if (frame.getWidth() != width || frame.getHeight() != height || spacing != this->spacing){
+        setup(frame.getWidth(), frame.getHeight(), spacing);
+    }
+
+    // Sample the whole frame, it's a lot cheaper than triangulating it
+    for (int sy = 0; sy < samplesY; sy++){
+        for (int sx = 0; sx < samplesX; sx++){
+            int x = sx * spacing;
+            int y = sy * spacing;
+            float depth = 0;
+            if (mask[x + y * width] > 0){
+                depth = frame.getDistanceAt(x, y);
+                if (depth <= near || depth >= far) depth = 0;
+            }
+            depths[sx + sy * samplesX] = depth;
+        }
+    }
+
+    rebuilding.clear();
+    for (size_t i = 0; i < tiles.size(); i++){
+        if (hasChanged(tiles[i])) rebuilding.push_back(i);
+    }
+    numRebuilt = rebuilding.size();
+
+    auto job = [&](int i){
+        rebuild(tiles[rebuilding[i]]);
+    };
+    if (pool != NULL) pool->parallelFor(numRebuilt, job);
+    else for (int i = 0; i < numRebuilt; i++) job(i);
+
+    // Neighbours share their edge samples, so positions are only written back
+    // once every tile is done with them
+    for (int i = 0; i < numRebuilt; i++){
+        const Tile& tile = tiles[rebuilding[i]];
+        for (size_t j = 0; j < tile.samples.size(); j++){
+            positions[tile.samples[j]] = tile.points[j];
+        }
+    }
+
+    // The seams only move with the tiles either side of them
+    if (numRebuilt > 0) stitch();
+    return numRebuilt;
+}
+
+//--------------------------------------------------------------
+void TiledDelaunay::invalidate(){
+    for (size_t i = 0; i < tiles.size(); i++){
+        tiles[i].bBuilt = false;
+    }
+}
+
+//--------------------------------------------------------------
+void TiledDelaunay::setChangeThreshold(float millimetres){
+    changeThreshold = millimetres;
+}
+
+//--------------------------------------------------------------
+float TiledDelaunay::getChangeThreshold() const {
+    return changeThreshold;
+}
+
+//--------------------------------------------------------------
+bool TiledDelaunay::hasChanged(Tile& tile){
+
+    if (!tile.bBuilt) return true;
+
+    // Mean absolute change against the depth it was built from, rather than
+    // the last frame, so a slow drift still adds up. A sample dropping on or
+    // off the mask counts as its whole depth.
+    float change = 0;
+    int n = 0;
+    for (int sy = tile.y0; sy <= tile.y1; sy++){
+        for (int sx = tile.x0; sx <= tile.x1; sx++){
+            change += fabs(depths[sx + sy * samplesX] - tile.reference[n++]);
+        }
+    }
+    return change / n > changeThreshold;
+}
+
+//--------------------------------------------------------------
+void TiledDelaunay::rebuild(Tile& tile){
+
+    tile.points.clear();
+    tile.lattice.clear();
+    tile.samples.clear();
+    tile.indices.clear();
+
+    // Same walk as a full triangulation, x then y
+    int n = 0;
+    for (int sx = tile.x0; sx <= tile.x1; sx++){
+        for (int sy = tile.y0; sy <= tile.y1; sy++){
+            int sample = sx + sy * samplesX;
+            float depth = depths[sample];
+            tile.reference[(sy - tile.y0) * (tile.x1 - tile.x0 + 1) + (sx - tile.x0)] = depth;
+            if (depth == 0) continue;
+
+            tile.points.push_back(ofPoint(sx * spacing - width / 2.0, sy * spacing - height / 2.0, -depth));
+            tile.lattice.push_back(getLatticePoint(sample));
+            tile.samples.push_back(sample);
+            n++;
+        }
+    }
+    tile.fans.assign(n, 0);
+    tile.bBuilt = true;
+
+    if (n < 3) return;
+
+    tile.del.reset();
+    tile.del.addPoints(tile.lattice);
+    tile.del.triangulate();
+
+    // Keep what the neighbours couldn't have changed, the seams get the rest
+    const ofMesh& mesh = tile.del.triangleMesh;
+    for (size_t i = 0; i + 2 < mesh.getNumIndices(); i += 3){
+        int corners[3] = { (int)mesh.getIndex(i), (int)mesh.getIndex(i + 1), (int)mesh.getIndex(i + 2) };
+        const ofPoint& a = tile.lattice[corners[0]];
+        const ofPoint& b = tile.lattice[corners[1]];
+        const ofPoint& c = tile.lattice[corners[2]];
+        if (!isSettled(tile, a, b, c)) continue;
+
+        for (int k = 0; k < 3; k++){
+            tile.indices.push_back(corners[k]);
+
+            // The angle at this corner, towards how far round it's closed
+            const ofPoint& p = tile.lattice[corners[k]];
+            const ofPoint& q = tile.lattice[corners[(k + 1) % 3]];
+            const ofPoint& r = tile.lattice[corners[(k + 2) % 3]];
+            double ux = q.x - p.x, uy = q.y - p.y;
+            double vx = r.x - p.x, vy = r.y - p.y;
+            tile.fans[corners[k]] += atan2(fabs(ux * vy - uy * vx), ux * vx + uy * vy);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+bool TiledDelaunay::isSettled(const Tile& tile, const ofPoint& a, const ofPoint& b, const ofPoint& c) const {
+
+    // Circumcircle, relative to a to keep the precision
+    double bx = b.x - a.x, by = b.y - a.y;
+    double cx = c.x - a.x, cy = c.y - a.y;
+    double d = 2 * (bx * cy - by * cx);
+    if (fabs(d) < 1e-9) return false;
+    double b2 = bx * bx + by * by;
+    double c2 = cx * cx + cy * cy;
+    double ux = (cy * b2 - by * c2) / d;
+    double uy = (bx * c2 - cx * b2) / d;
+    double r = sqrt(ux * ux + uy * uy);
+    ux += a.x;
+    uy += a.y;
+
+    // If it stays inside the tile, no sample the tile can't see could be in
+    // it, so the whole image's triangulation has it too. The nearest of those
+    // is a whole sample past the edge, which leaves half a sample for the
+    // nudges and the rounding. Past the edge of the image there's nothing.
+    if (tile.x0 > 0 && ux - r < tile.x0 - 0.5) return false;
+    if (tile.y0 > 0 && uy - r < tile.y0 - 0.5) return false;
+    if (tile.x1 < samplesX - 1 && ux + r > tile.x1 + 0.5) return false;
+    if (tile.y1 < samplesY - 1 && uy + r > tile.y1 + 0.5) return false;
+    return true;
+}
+
+//--------------------------------------------------------------
+void TiledDelaunay::stitch(){
+
+    // A sample the kept triangles close all the way round is walled in, the
+    // seams can't reach it. Every other sample a tile triangulated is on one.
+    std::fill(fans.begin(), fans.end(), 0);
+    for (size_t t = 0; t < tiles.size(); t++){
+        const Tile& tile = tiles[t];
+        for (size_t j = 0; j < tile.samples.size(); j++){
+            fans[tile.samples[j]] += tile.fans[j];
+        }
+    }
+
+    std::fill(seamVertex.begin(), seamVertex.end(), -1);
+    seamSamples.clear();
+    seamLattice.clear();
+    for (size_t t = 0; t < tiles.size(); t++){
+        const Tile& tile = tiles[t];
+        for (size_t j = 0; j < tile.samples.size(); j++){
+            int sample = tile.samples[j];
+            if (seamVertex[sample] >= 0 || fans[sample] > TWO_PI - 1e-3) continue;
+            seamVertex[sample] = seamSamples.size();
+            seamSamples.push_back(sample);
+            seamLattice.push_back(tile.lattice[j]);
+        }
+    }
+
+    seamIndices.clear();
+    if (seamSamples.size() < 3) return;
+
+    seamDel.reset();
+    seamDel.addPoints(seamLattice);
+    seamDel.triangulate();
+
+    // Without the walled in samples this also bridges over the kept
+    // triangles, but never half over them, so a triangle is the seam's if
+    // its middle isn't under one
+    const ofMesh& mesh = seamDel.triangleMesh;
+    for (size_t i = 0; i + 2 < mesh.getNumIndices(); i += 3){
+        int a = mesh.getIndex(i);
+        int b = mesh.getIndex(i + 1);
+        int c = mesh.getIndex(i + 2);
+        ofPoint centroid = (seamLattice[a] + seamLattice[b] + seamLattice[c]) / 3;
+        if (isCovered(centroid)) continue;
+        seamIndices.push_back(seamSamples[a]);
+        seamIndices.push_back(seamSamples[b]);
+        seamIndices.push_back(seamSamples[c]);
+    }
+}
+
+//--------------------------------------------------------------
+bool TiledDelaunay::isCovered(const ofPoint& point) const {
+
+    // Only the tiles it could be in, give or take a nudge over their edges
+    int tx0 = ofClamp(floor((point.x - 0.5) / TILE_SAMPLES), 0, tilesX - 1);
+    int tx1 = ofClamp(floor((point.x + 0.5) / TILE_SAMPLES), 0, tilesX - 1);
+    int ty0 = ofClamp(floor((point.y - 0.5) / TILE_SAMPLES), 0, tilesY - 1);
+    int ty1 = ofClamp(floor((point.y + 0.5) / TILE_SAMPLES), 0, tilesY - 1);
+
+    for (int ty = ty0; ty <= ty1; ty++){
+        for (int tx = tx0; tx <= tx1; tx++){
+            const Tile& tile = tiles[tx + ty * tilesX];
+            for (size_t i = 0; i + 2 < tile.indices.size(); i += 3){
+                const ofPoint& a = tile.lattice[tile.indices[i]];
+                const ofPoint& b = tile.lattice[tile.indices[i + 1]];
+                const ofPoint& c = tile.lattice[tile.indices[i + 2]];
+                if (point.x < min(a.x, min(b.x, c.x)) || point.x > max(a.x, max(b.x, c.x))
+                    || point.y < min(a.y, min(b.y, c.y)) || point.y > max(a.y, max(b.y, c.y))) continue;
+
+                // Inside, or on an edge, if it's on the same side of all three
+                double d1 = (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+                double d2 = (c.x - b.x) * (point.y - b.y) - (c.y - b.y) * (point.x - b.x);
+                double d3 = (a.x - c.x) * (point.y - c.y) - (a.y - c.y) * (point.x - c.x);
+                bool bNegative = d1 < -1e-9 || d2 < -1e-9 || d3 < -1e-9;
+                bool bPositive = d1 > 1e-9 || d2 > 1e-9 || d3 > 1e-9;
+                if (!(bNegative && bPositive)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+ofPoint TiledDelaunay::getLatticePoint(int sample) const {
+
+    // A fixed nudge for each sample, hashed from which it is
+    int sx = sample % samplesX;
+    int sy = sample / samplesX;
+    uint32_t hash = (uint32_t)sample * 2654435761u;
+    float nx = ((hash >> 8) & 255) / 255.0 - 0.5;
+    float ny = ((hash >> 16) & 255) / 255.0 - 0.5;
+    return ofPoint(sx + nx * NUDGE, sy + ny * NUDGE);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxDelaunay.h"
+#include "KinectFrame.h"
+#include "ThreadPool.h"
+
+// Triangulates the sampled depth image tile by tile, and only re-triangulates
+// the tiles whose depth has moved since they were last built. Someone standing
+// nearly still only costs the handful of tiles around whatever moved.
+//
+// Neighbouring tiles share the samples along their common edge, and every
+// triangle refers to its corners by sample rather than by position, so a
+// rebuilt tile and a cached one always meet at the same vertices.
+//
+// A tile only keeps the triangles whose circumcircle stays well inside it,
+// since nothing from the neighbours could have changed those. Whatever's left
+// between them, the seams, is filled in by one more triangulation of just the
+// samples the kept triangles don't wall in all the way round. Between them
+// they come out as the triangulation of the whole image would.
+//
+// The samples sit on a grid, so any four round a cell are on a circle and
+// which way the cell gets split is a coin toss. Each sample is nudged by a
+// fixed fraction of a sample before triangulating, the same in every tile,
+// so every triangulation tosses the same way.
+//
+// Tiles are independent of each other until their vertices are written back,
+// so given a thread pool they're triangulated in parallel.
+
+class TiledDelaunay {
+
+    public:
+        struct Tile {
+            int x0, y0, x1, y1;         // Sample grid bounds, inclusive
+            vector<int> samples;        // Tile vertex -> sample, in the order they were triangulated
+            vector<int> indices;        // Triangles the tile is sure of, as tile vertices
+            vector<float> reference;    // Depth of each sample in the bounds when last built
+            bool bBuilt;
+
+            ofxDelaunay del;
+            vector<ofPoint> points;     // Where each tile vertex is
+            vector<ofPoint> lattice;    // And where it was triangulated, in nudged samples
+            vector<float> fans;         // Angle its triangles close round each tile vertex
+        };
+
+        TiledDelaunay();
+
+        void setThreadPool(ThreadPool* pool);       // NULL to triangulate on the calling thread
+
+        // Samples the frame every `spacing` pixels and re-triangulates the
+        // tiles that changed. Returns how many were rebuilt.
+        int update(const KinectFrame& frame, const unsigned char* mask, int spacing, float near, float far);
+        void invalidate();                          // Rebuild everything on the next update
+
+        void setChangeThreshold(float millimetres); // Mean depth change that rebuilds a tile
+        float getChangeThreshold() const;
+
+        const vector<Tile>& getTiles() const { return tiles; }
+        const vector<int>& getSeamIndices() const { return seamIndices; }    // Triangles, as samples
+        const ofVec3f& getSample(int sample) const { return positions[sample]; }
+        ofPoint getLatticePoint(int sample) const;  // Where it's triangulated, in nudged samples
+        int getNumSamples() const { return positions.size(); }
+        int getNumRebuilt() const { return numRebuilt; }
+
+    private:
+        void setup(int width, int height, int spacing);
+        bool hasChanged(Tile& tile);
+        void rebuild(Tile& tile);
+        bool isSettled(const Tile& tile, const ofPoint& a, const ofPoint& b, const ofPoint& c) const;
+        void stitch();
+        bool isCovered(const ofPoint& point) const;
+
+        static const int TILE_SAMPLES = 16;         // Sample spacings along a tile's side
+        static constexpr float NUDGE = 1 / 16.0;    // Spread of the nudges, in samples
+
+        int width;
+        int height;
+        int spacing;
+        int samplesX;
+        int samplesY;
+        float changeThreshold;
+
+        vector<float> depths;       // This frame's depth at each sample, 0 when it's off the mask
+        vector<ofVec3f> positions;  // Each sample's position as of the last tile to build it
+        vector<Tile> tiles;
+        int tilesX;
+        int tilesY;
+        vector<int> rebuilding;     // Tiles being rebuilt this update
+
+        ofxDelaunay seamDel;
+        vector<ofPoint> seamLattice;
+        vector<int> seamSamples;    // Seam vertex -> sample
+        vector<int> seamVertex;     // Sample -> seam vertex, -1 if it isn't on a seam
+        vector<float> fans;         // Angle the kept triangles close round each sample
+        vector<int> seamIndices;
+        int numRebuilt;
+        ThreadPool* pool;
+};
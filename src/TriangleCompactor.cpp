@@ -0,0 +1,149 @@
+#include "TriangleCompactor.h"
+#include <climits>
+
+// The RGB pixel under a vertex
+static inline int pixelUnder(const ofVec3f& p, int width, int height){
+    int x = ofClamp(p.x + width / 2, 1, width - 1);
+    int y = ofClamp(p.y + height / 2, 1, height - 1);
+    return x + y * width;
+}
+
+static inline void atomicMin(std::atomic<int>& a, int value){
+    int current = a.load(std::memory_order_relaxed);
+    while (value < current && !a.compare_exchange_weak(current, value, std::memory_order_relaxed)){}
+}
+
+//--------------------------------------------------------------
+TriangleCompactor::TriangleCompactor()
+:pool(NULL){
+}
+
+//--------------------------------------------------------------
+void TriangleCompactor::setThreadPool(ThreadPool* pool){
+    this->pool = pool;
+}
+
+//--------------------------------------------------------------
+void TriangleCompactor::setup(int maxIds, int maxTriangles){
+    keep.reserve(maxTriangles);
+    remap.reserve(maxIds);
+    if ((int)firstUse.size() < maxIds) vector<std::atomic<int>>(maxIds).swap(firstUse);
+    int maxChunks = (maxTriangles + CHUNK_TRIANGLES - 1) / CHUNK_TRIANGLES;
+    keptOffsets.reserve(maxChunks + 1);
+    vertexOffsets.reserve(maxChunks + 1);
+}
+
+//--------------------------------------------------------------
+int TriangleCompactor::compact(const MaskCoverage& coverage, float threshold, const int* ids, const ofVec3f* corners,
+                               int count, int numIds, int width, int height,
+                               vector<ofVec3f>& vertices, vector<int>& colorPixels, vector<ofIndexType>& indices){
+
+    int numChunks = (count + CHUNK_TRIANGLES - 1) / CHUNK_TRIANGLES;
+    keep.resize(count);
+    remap.resize(numIds);
+    if ((int)firstUse.size() < numIds) vector<std::atomic<int>>(numIds).swap(firstUse);
+    keptOffsets.assign(numChunks + 1, 0);
+    vertexOffsets.assign(numChunks + 1, 0);
+
+    // Which triangles are kept, and nobody has claimed a vertex yet
+    auto accept = [&](int c){
+        int begin = c * CHUNK_TRIANGLES;
+        int end = min(count, begin + CHUNK_TRIANGLES);
+        coverage.cull(corners + begin * 3, end - begin, threshold, &keep[begin]);
+        int kept = 0;
+        for (int i = begin; i < end; i++) kept += keep[i];
+        keptOffsets[c + 1] = kept;
+
+        int idEnd = (int64_t)numIds * (c + 1) / numChunks;
+        for (int id = (int64_t)numIds * c / numChunks; id < idEnd; id++){
+            firstUse[id].store(INT_MAX, std::memory_order_relaxed);
+        }
+    };
+    run(numChunks, accept);
+
+    // Each vertex goes to the first corner of a kept triangle to use it
+    auto claim = [&](int c){
+        int end = min(count, (c + 1) * CHUNK_TRIANGLES) * 3;
+        for (int corner = c * CHUNK_TRIANGLES * 3; corner < end; corner++){
+            if (keep[corner / 3]) atomicMin(firstUse[ids[corner]], corner);
+        }
+    };
+    run(numChunks, claim);
+
+    auto countVertices = [&](int c){
+        int end = min(count, (c + 1) * CHUNK_TRIANGLES) * 3;
+        int claimed = 0;
+        for (int corner = c * CHUNK_TRIANGLES * 3; corner < end; corner++){
+            claimed += firstUse[ids[corner]].load(std::memory_order_relaxed) == corner;
+        }
+        vertexOffsets[c + 1] = claimed;
+    };
+    run(numChunks, countVertices);
+
+    // Counts to offsets. There are only ever a few dozen chunks.
+    for (int c = 0; c < numChunks; c++){
+        keptOffsets[c + 1] += keptOffsets[c];
+        vertexOffsets[c + 1] += vertexOffsets[c];
+    }
+    vertices.resize(vertexOffsets[numChunks]);
+    colorPixels.resize(vertexOffsets[numChunks]);
+    indices.resize(keptOffsets[numChunks] * 3);
+
+    auto scatterVertices = [&](int c){
+        int end = min(count, (c + 1) * CHUNK_TRIANGLES) * 3;
+        int out = vertexOffsets[c];
+        for (int corner = c * CHUNK_TRIANGLES * 3; corner < end; corner++){
+            int id = ids[corner];
+            if (firstUse[id].load(std::memory_order_relaxed) != corner) continue;
+            vertices[out] = corners[corner];
+            colorPixels[out] = pixelUnder(corners[corner], width, height);
+            remap[id] = out++;
+        }
+    };
+    run(numChunks, scatterVertices);
+
+    // Every vertex has its place now, wherever it was claimed
+    auto scatterIndices = [&](int c){
+        int begin = c * CHUNK_TRIANGLES;
+        int end = min(count, begin + CHUNK_TRIANGLES);
+        ofIndexType* out = indices.empty() ? NULL : &indices[keptOffsets[c] * 3];
+        for (int i = begin; i < end; i++){
+            if (!keep[i]) continue;
+            *out++ = remap[ids[i*3]];
+            *out++ = remap[ids[i*3+1]];
+            *out++ = remap[ids[i*3+2]];
+        }
+    };
+    run(numChunks, scatterIndices);
+
+    return keptOffsets[numChunks];
+}
+
+//--------------------------------------------------------------
+int TriangleCompactor::compactSerial(const MaskCoverage& coverage, float threshold, const int* ids, const ofVec3f* corners,
+                                     int count, int numIds, int width, int height,
+                                     vector<ofVec3f>& vertices, vector<int>& colorPixels, vector<ofIndexType>& indices){
+
+    vertices.clear();
+    colorPixels.clear();
+    indices.clear();
+    keep.resize(count);
+    remap.assign(numIds, -1);
+    if (count > 0) coverage.cull(corners, count, threshold, &keep[0]);
+
+    int kept = 0;
+    for (int corner = 0; corner < count * 3; corner++){
+        if (!keep[corner / 3]) continue;
+
+        // Already in the mesh from a neighbouring triangle
+        int& indx = remap[ids[corner]];
+        if (indx < 0){
+            indx = vertices.size();
+            vertices.push_back(corners[corner]);
+            colorPixels.push_back(pixelUnder(corners[corner], width, height));
+        }
+        indices.push_back(indx);
+        kept += corner % 3 == 2;
+    }
+    return kept;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ofMain.h"
+#include "MaskCoverage.h"
+#include "ThreadPool.h"
+
+// Turns the meshers' queued triangles into the output mesh: drops the ones
+// off the subject, then writes each surviving vertex once and indexes the
+// triangles into it.
+//
+// Done as a stream compaction across the thread pool. Each chunk of
+// triangles works out which it keeps, and which of its corners is the first
+// kept use of a vertex. Prefix sums of those counts give every chunk its
+// offsets into the output, which it then scatters into from its own thread.
+// Vertices come out in the order of their first use, the same order, and so
+// the same mesh, as adding them one triangle at a time.
+
+class TriangleCompactor {
+
+    public:
+        TriangleCompactor();
+
+        void setThreadPool(ThreadPool* pool);   // NULL to compact on the calling thread
+        void setup(int maxIds, int maxTriangles);
+
+        // Triangles come as three vertex ids and three corners each, ids
+        // running from 0 to numIds. Corners are centred on the width x height
+        // image, and colorPixels gets the RGB pixel under each output vertex.
+        // Returns how many triangles were kept.
+        int compact(const MaskCoverage& coverage, float threshold, const int* ids, const ofVec3f* corners,
+                    int count, int numIds, int width, int height,
+                    vector<ofVec3f>& vertices, vector<int>& colorPixels, vector<ofIndexType>& indices);
+
+        // One triangle at a time, as a reference
+        int compactSerial(const MaskCoverage& coverage, float threshold, const int* ids, const ofVec3f* corners,
+                          int count, int numIds, int width, int height,
+                          vector<ofVec3f>& vertices, vector<int>& colorPixels, vector<ofIndexType>& indices);
+
+    private:
+        template<typename F>
+        void run(int count, F& job){
+            if (pool != NULL) pool->parallelFor(count, job);
+            else for (int i = 0; i < count; i++) job(i);
+        }
+
+        static const int CHUNK_TRIANGLES = 2048;
+
+        vector<unsigned char> keep;             // Per triangle
+        vector<int> remap;                      // Vertex id -> output vertex
+        vector<std::atomic<int>> firstUse;      // Vertex id -> first corner of a kept triangle to use it
+        vector<int> keptOffsets;                // Per chunk, where its triangles go in the output...
+        vector<int> vertexOffsets;              // ...and its vertices
+        ThreadPool* pool;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free handoff of the newest value from one writer thread to one reader
+// thread. The writer fills the back slot and publishes it, the reader takes
+// whatever was published last; neither ever waits on the other, and frames
+// the reader didn't get to in time are simply overwritten.
+
+template<typename T>
+class TripleBuffer {
+
+    public:
+        TripleBuffer() : front(0), back(1), middle(2){}
+
+        // Writer side
+        T& getBack(){ return buffers[back]; }
+
+        // Hand the back slot over to the reader. Returns false if that
+        // overwrote a value the reader never picked up.
+        bool publish(){
+            unsigned char previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+            back = previous & INDEX;
+            return !(previous & FRESH);
+        }
+
+        // Reader side. Swap in the newest published value, if there is one.
+        bool consume(){
+            if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+            unsigned char previous = middle.exchange(front, std::memory_order_acq_rel);
+            front = previous & INDEX;
+            return true;
+        }
+
+        T& getFront(){ return buffers[front]; }
+        const T& getFront() const { return buffers[front]; }
+
+    private:
+        static const unsigned char INDEX = 0x3;
+        static const unsigned char FRESH = 0x4;
+
+        T buffers[3];
+        int front;                          // Only touched by the reader
+        int back;                           // Only touched by the writer
+        std::atomic<unsigned char> middle;  // Shared slot index, plus the fresh flag
+};
@@ -1,11 +1,88 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "ofAppNoWindow.h"
 
 //========================================================================
-int main( ){
-    
-	ofSetupOpenGL(1280,960,OF_FULLSCREEN);  // Trying window as the same ratio as the kinect,
-                                        // Having ofxPostProcessing aspect ratio issue...
-	ofRunApp(new ofApp());
+// Usage:
+//      capgrasDelusion_03                              Live kinect
+//      capgrasDelusion_03 --replay session.cgrs        Replay at the recorded rate
+//          --rate native | max | <fps>                 How fast to play it back
+//          --realtime                                  Start in realtime rather than portrait mode
+//          --headless                                  No window, play it once, log timings and quit
+//                                                      (implies --rate max)
+//      capgrasDelusion_03 --record session.cgrs        Record the kinect from the start
+//      capgrasDelusion_03 --target-fps 30              Frame rate to adjust the mesh density for
 
+
+static void printUsage(){
+    ofLogError("main") << "usage: capgrasDelusion_03 [--replay <recording> [--rate native | max | <fps>]"
+                       << " [--realtime] [--headless]] [--record <recording>] [--target-fps <fps>]";
+}
+
+// A frame rate has to be a number, all of it, and more than 0
+static bool parseFps(const string& text, float& fps){
+    char* end = NULL;
+    double value = strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !(value > 0) || std::isinf(value)) return false;
+    fps = value;
+    return true;
+}
+
+int main(int argc, char *argv[]){
+
+    ofApp *app = new ofApp();
+
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc){
+            app->replayPath = argv[++i];
+        }
+        else if (arg == "--rate" && i + 1 < argc){
+            string rate = argv[++i];
+            if (rate == "native") app->replayRate = REPLAY_NATIVE;
+            else if (rate == "max") app->replayRate = REPLAY_MAX;
+            else if (parseFps(rate, app->replayFps)){
+                app->replayRate = REPLAY_FIXED;
+            }
+            else {
+                ofLogError("main") << "--rate takes native, max or frames per second above 0, not \"" << rate << "\"";
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--record" && i + 1 < argc){
+            app->recordPath = argv[++i];
+        }
+        else if (arg == "--target-fps" && i + 1 < argc){
+            string fps = argv[++i];
+            if (!parseFps(fps, app->targetFps)){
+                ofLogError("main") << "--target-fps takes frames per second above 0, not \"" << fps << "\"";
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--realtime"){
+            app->bStartRealTime = true;
+        }
+        else if (arg == "--headless"){
+            app->bHeadless = true;
+        }
+    }
+
+    if (app->bHeadless){
+        if (app->replayPath.empty()){
+            ofLogError("main") << "--headless needs a recording to --replay";
+            return 1;
+        }
+        app->replayRate = REPLAY_MAX;
+
+        ofAppNoWindow window;
+        ofSetupOpenGL(&window, 1280, 960, OF_WINDOW);
+        ofRunApp(app);
+    }
+    else {
+        ofSetupOpenGL(1280,960,OF_FULLSCREEN);  // Trying window as the same ratio as the kinect,
+                                                // Having ofxPostProcessing aspect ratio issue...
+        ofRunApp(app);
+    }
 }
@@ -56,24 +56,47 @@ void ofApp::setup(){
     ofSetVerticalSync(true);
     ofSetBackgroundAuto(true);
     
-    //Initialise the kinect
-    initKinect();
+    //Initialise the kinect, giving up if there's nothing to show
+    if (!initKinect()) return;
     
-    // Set up the tracker
-    tracker.setup();
-    tracker.setRescale(.5);
+    // Set up the tracker, on its own thread unless every run has to match
+    faceTracker.setup(!bDeterministic);
     captureFaceTimer = 0;
     
+    // Hold the meshing to the frame rate we're after. A deterministic replay
+    // has to mesh the same way every run, however long it takes.
+    bDensityControl = !bDeterministic;
+    density.setup(1000.0 / targetFps, spacing, 1, 8, vertexBudget, 1000, 20000);
+    
+    // Mesh off the render loop, spreading the work across every core. A
+    // deterministic replay meshes every frame in line instead.
+    threadPool.setup();
+    meshing.setup(&threadPool, !bDeterministic);
+    
+    // And displace it across every core too, each vertex on its own
+    modulationPool.setup();
+    modulator.setThreadPool(&modulationPool);
+    
+    // Bake each scene's noise in the background. A deterministic replay
+    // bakes it on the spot, so every run looks it up from the first frame.
+    noiseVolumes.setup(!bDeterministic);
+    
     // Initialise the scene, GUI and postFX
     initCamera(camNum);
     initBG();
-    initGUI();
-    initPostFX();
+    if (!bHeadless){
+        initGUI();
+        initPostFX();
+        initShaders();
+    }
+    
+    // A deterministic replay should pick the same 'random' scenes every run
+    if (bDeterministic) ofSeedRandom(0);
     
     // Set initial booleans
     bFaceCaptured = false;
-    bEnableFX = true;
-    bIsRealTime = false;
+    bEnableFX = !bHeadless;
+    bIsRealTime = bStartRealTime;
     bWireframe = true;
     bFaces = true;
     bPoints = false;
@@ -83,6 +106,26 @@ void ofApp::setup(){
     captureFaceTimerMax = 60; // Amount of time to take a portrait and for each scene,
                               // default 60 but should increase if i'm able to increase the frameRate
                               // which is currently +/- 10fps :(
+    desatVal = 1.9;           // Divides the colour saturation. It's an int, so this is 1 and
+                              // the piece has always shown the kinect's colours as they are
+    
+    if (!recordPath.empty()){
+        recorder.start(recordPath, kinect->getWidth(), kinect->getHeight(), kinect->getWorldScale());
+    }
+    bSetUp = true;
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+    
+    // Make sure a recording gets its index written
+    faceTracker.stop();
+    meshing.stop();
+    threadPool.stop();
+    modulationPool.stop();
+    noiseVolumes.stop();
+    capture.stop();
+    recorder.stop();
 }
 
                                 /////////////////////
@@ -93,16 +136,22 @@ void ofApp::setup(){
 
 void ofApp::update(){
     
-    // Update the kinect images
-    kinect.update();
+    if (!bSetUp) return;
+    
+    // Pick up the newest frame from the capture thread
+    bench.begin("kinect");
+    capture.update();
     
     // If there is a new frame and we are connected...
-    if(kinect.isFrameNew()) {
-        kinectDepth.setFromPixels(kinect.getDepthPixels());
-        kinectDepth.flagImageChanged();
-        kinectColor.setFromPixels(kinect.getPixels());
-        kinectColor.flagImageChanged();
+    // The tracker and mesher hold on to it rather than copying it, only the
+    // recorder copies, and only while it's recording.
+    if(capture.isFrameNew()) {
+        const KinectFrame& frame = capture.getFrame();
+        if (recorder.isRecording()){
+            recorder.addFrame(frame.rawDepth, frame.color);
+        }
     }
+    bench.end("kinect");
     
     // Make meaningful choices...
     theDirector();
@@ -110,25 +159,82 @@ void ofApp::update(){
     // Update the face grabber
     updateFaceGrabber();
     
-    // In realtime mode, update the mesh every frame
-    if (bIsRealTime){
+    // In realtime mode, update the mesh every frame. A portrait the mesher
+    // was too busy for gets offered again until it's taken.
+    if (bIsRealTime || bMeshPending){
         updateDelaunay();
     }
     
-    // Modulate each vertex of the Delaunay mesh every frame
-    modulateDelaunay();
+    // Pick up the newest mesh, if there is one. It's swapped in, not copied.
+    meshing.update();
+    if (meshing.isMeshNew()){
+        bMaskChanged = true;
+    }
+    
+    // Displace the Delaunay mesh from its rest positions every frame, unless
+    // the vertex shader is doing it as the mesh is drawn
+    float modulating = 0;
+    if (!bGpuNoise){
+        modulateDelaunay();
+        modulating = bench.getLastMillis("modulateDelaunay");
+    }
+    bSceneChanged = false;
+    
+    // Trade mesh density for frame time. In realtime mode meshing runs
+    // alongside the render loop every frame, so whichever of them is slower
+    // sets the pace. A portrait is only meshed once every captureFaceTimerMax
+    // frames, so its cost is spread over them on top of the render loop's.
+    if (bDensityControl){
+        // Only counting the modulation if it ran this frame, the vertex
+        // shader takes it off the CPU
+        float rendering = modulating + bench.getLastMillis("draw");
+        float millis = bIsRealTime ? max(meshing.getLastMillis(), rendering)
+                                   : rendering + meshing.getLastMillis() / captureFaceTimerMax;
+        
+        // Only step whichever the mesher is sampling by
+        bool bBudget = bAdaptiveSampling && !bGridMesher;
+        if (density.update(millis, bBudget ? DensityController::VERTEX_BUDGET : DensityController::SPACING)){
+            spacing = density.getSpacing();
+            vertexBudget = density.getVertexBudget();
+            ofLogVerbose("ofApp") << "meshing at spacing " << spacing << ", budget " << density.getVertexBudget()
+                                  << ", " << ofToString(density.getSmoothedMillis(), 1) << " ms";
+        }
+    }
     
     // Increment the timer
     timer++;
+    
+    bench.addToChecksum(meshing.getOutput().mesh);
+    bench.addFrame();
+    
+    // Running headless, we're done once the recording runs out
+    if (bHeadless && replay->isFinished()){
+        bench.report();
+        meshing.reportBench();
+        bool bPassed = runBenchmarks();
+        
+        // Settled meshing has to stay off the heap, so fail the run if it didn't
+        int allocating = meshing.getAllocatingBuilds();
+        if (allocating > 0){
+            ofLogError("ofApp") << allocating << " settled mesh builds touched the heap";
+            bPassed = false;
+        }
+        ofExit(bPassed ? 0 : 1);
+    }
 }
 
 void ofApp::updateFaceGrabber(){
-    // Update the tracker with the kinect's RGB image
-    tracker.update(toCv(kinectColor));
+    // Offer the tracker the kinect's newest RGB image and take whatever it
+    // found last. It runs at its own pace, so this never waits on it.
+    bench.begin("tracker");
+    if (capture.isFrameNew()) faceTracker.submit(capture.shareFrame());
+    faceTracker.update();
+    bench.end("tracker");
 
-    cropX = tracker.getPosition().x;
-    cropY = tracker.getPosition().y;
-    float faceSize = tracker.getScale();
+    const FaceSnapshot& face = faceTracker.getSnapshot();
+    cropX = face.position.x;
+    cropY = face.position.y;
+    float faceSize = face.scale;
     cropW = faceSize * pixelScale;
     cropH = faceSize * pixelScale * ratio;
     cropY -= cropH/fudge;
@@ -148,181 +254,84 @@ void ofApp::updateFaceGrabber(){
 
 void ofApp::updateDelaunay(){
     
-    del.reset();
-    
-    // Create a pixel array to store our depth values.
-    unsigned char* pix = new unsigned char[640*480];
-    
-    // Loop through every pixel of the kinect and check the distance
-    
-    for(int x = 0; x < kinect.width; x++) {
-        for(int y = 0; y < kinect.height; y++) {
-            
-            float distance = kinect.getDistanceAt(x, y);
-            int pIndex = x + y * 640;
-            pix[pIndex] = 0;
-            
-            if(distance > depthNear && distance < depthFar) {
-                
-                // If it's within the threshold, mark the pixel as white
-                pix[pIndex] = 255;
-            }
-        }
-    }
-    
-    
-    // Set the blob image to be from the grayscale pix array.
-    blob.setFromPixels(pix, kinect.width,kinect.height, OF_IMAGE_GRAYSCALE);
-    
-    int numPoints = 0;
-    
-    // Loop through the whole kinect image
-    for(int x = 0; x < kinect.width; x += spacing) {
-        for(int y = 0; y < kinect.height; y += spacing) {
-            int pIndex = x + 640 * y;
-            
-            // If there is a pixel at the index
-            if(blob.getPixels()[pIndex] > 0) {
-                
-                // Create a temp vector at that pixels world position
-                ofVec3f wc = kinect.getWorldCoordinateAt(x, y);
-                
-                // Subtract the depth image w/h
-                wc.x = x - 320.0;
-                wc.y = y - 240.0;
-                
-                // If it's within the threshold...
-                if(abs(wc.z) > depthNear && abs(wc.z ) < depthFar) {
-                    
-                    // flip the Z axis
-                    wc.z = -wc.z;
-                    // And add the point to the delaunay
-                    del.addPoint(wc);
-                }
-                numPoints++;
-            }
-        }
-    }
-    
-    // If we have more than 0 points, triangulate
-    if(numPoints > 0)
-        del.triangulate();
-    
-    // Initialise the delaunay with a colour
-    for(int i=0;i<del.triangleMesh.getNumVertices();i++) {
-        del.triangleMesh.addColor(ofColor(0,0,0));
-    }
+    // Hand the newest frame to the meshing thread, which builds the mesh
+    // while we carry on drawing the last one. In realtime mode a frame it's
+    // too busy for is simply skipped, a portrait is held until it's taken.
+    bench.begin("updateDelaunay");
+    bMeshPending = !meshing.submit(capture.shareFrame(), getMeshSettings());
+    bench.end("updateDelaunay");
+}
 
-    // And set that colour to the corresponding vertices' colour
-    for(int i=0;i<del.triangleMesh.getNumIndices()/3;i+=1) {
-        ofVec3f v = del.triangleMesh.getVertex(del.triangleMesh.getIndex(i*3));
-        
-        v.x = ofClamp(v.x, -319,319);
-        v.y = ofClamp(v.y, -239, 239);
-        
-        ofColor c = kinect.getColorAt(v.x+320.0, v.y+240.0);
-        c.a = 255;
-        
-        del.triangleMesh.setColor(del.triangleMesh.getIndex(i*3),c);
-        del.triangleMesh.setColor(del.triangleMesh.getIndex(i*3+1),c);
-        del.triangleMesh.setColor(del.triangleMesh.getIndex(i*3+2),c);
-    }
-    
-    // Clear both meshes
-    delaunayMesh.clear();
-    wireframeMesh.clear();
-    wireframeMesh.setMode(OF_PRIMITIVE_TRIANGLES);
-    
-    for(int i=0;i<del.triangleMesh.getNumIndices()/3;i+=1) {
-        
-        // Create indices and points from the triangulated mesh
-        
-        int indx1 = del.triangleMesh.getIndex(i*3);
-        ofVec3f p1 = del.triangleMesh.getVertex(indx1);
-        int indx2 = del.triangleMesh.getIndex(i*3+1);
-        ofVec3f p2 = del.triangleMesh.getVertex(indx2);
-        int indx3 = del.triangleMesh.getIndex(i*3+2);
-        ofVec3f p3 = del.triangleMesh.getVertex(indx3);
-        
-        ofVec3f triangleCenter = (p1+p2+p3)/3.0; // Determine the centre of the triangle
-        triangleCenter.x += 320; // Depth image width
-        triangleCenter.y += 240; // Depth image height
-        
-        triangleCenter.x = floor(ofClamp(triangleCenter.x, 0,640));
-        triangleCenter.y = floor(ofClamp(triangleCenter.y, 0, 480));
-        
-        int pixIndex = triangleCenter.x + triangleCenter.y * 640;
-        if(pix[pixIndex] > 0) {
-            
-                // Add vertices to the face mesh from the triangulted vertices
-                // and slightly desaturate...
-                desatVal = 1.9;
-                delaunayMesh.addVertex(p1);
-                ofColor dC1 = del.triangleMesh.getColor(indx1);
-                dC1.setSaturation(dC1.getSaturation() / desatVal);
-                delaunayMesh.addColor(dC1);
-                
-                delaunayMesh.addVertex(p2);
-                ofColor dC2 = del.triangleMesh.getColor(indx2);
-                dC2.setSaturation(dC2.getSaturation() / desatVal);
-                delaunayMesh.addColor(dC2);
-                
-                delaunayMesh.addVertex(p3);
-                ofColor dC3 = del.triangleMesh.getColor(indx3);
-                dC3.setSaturation(dC3.getSaturation() / desatVal);
-                delaunayMesh.addColor(dC3);
-            
-                // Do the same for the wireframe mesh
-                wireframeMesh.addVertex(p1);
-                ofColor wC1 = del.triangleMesh.getColor(indx1);
-                wC1.setSaturation(wC1.getSaturation() / desatVal);
-                wireframeMesh.addColor(wC1);
-            
-                wireframeMesh.addVertex(p2);
-                ofColor wC2 = del.triangleMesh.getColor(indx2);
-                wC2.setSaturation(wC2.getSaturation() / desatVal);
-                wireframeMesh.addColor(wC2);
-            
-                wireframeMesh.addVertex(p3);
-                ofColor wC3 = del.triangleMesh.getColor(indx3);
-                wC3.setSaturation(wC3.getSaturation() / desatVal);
-                wireframeMesh.addColor(wC3);
-        }
-    }
-    
-    // And delete the pixel array now we are done with it.
-    delete[] pix;
+MeshSettings ofApp::getMeshSettings(){
+    
+    MeshSettings settings;
+    settings.spacing = spacing;
+    settings.depthNear = depthNear;
+    settings.depthFar = depthFar;
+    settings.bGridMesher = bGridMesher;
+    settings.bTiledDelaunay = bTiledDelaunay;
+    settings.bAdaptiveSampling = bAdaptiveSampling;
+    settings.bIncremental = bIsRealTime;  // A portrait is meshed from scratch
+    settings.vertexBudget = vertexBudget;
+    settings.coverageThreshold = coverageThreshold;
+    settings.saturation = 1.0 / desatVal;
+    return settings;
+}
+
+NoiseVolume::Key ofApp::getNoiseKey(){
+    
+    NoiseVolume::Key key;
+    key.scale = noiseScale;
+    key.radius = noiseRadius;
+    key.bXZ = bNoiseMode;
+    key.width = kinect->getWidth();
+    key.height = kinect->getHeight();
+    key.depthFar = depthFar;
+    key.amount = noiseAmt;
+    return key;
+}
+
+void ofApp::requestNoiseVolume(const NoiseVolume::Key& key){
     
+    // Only asked for when the parameters change, whether theDirector() or a
+    // key changed them, not on every frame it's baking
+    if (key == requestedNoiseKey) return;
+    noiseVolumes.request(key);
+    requestedNoiseKey = key;
 }
 
 void ofApp::modulateDelaunay(){
     
-    // For each vertex in the mesh...
-    for (int i = 0; i < delaunayMesh.getVertices().size(); i++){
-        ofVec3f vecMod = delaunayMesh.getVertex(i);
-        float t = 1.0 * (ofGetElapsedTimef()) / 24;
-        
-        // Add 4D noise to our temporary vectors x/y position
-        if (bNoiseMode){
-            
-            vecMod.x += ofMap(ofSignedNoise(noiseScale * vecMod.x, noiseScale * vecMod.z, noiseRadius * sin(TWO_PI * t), noiseRadius * cos(TWO_PI * t)), -1, 1, -noiseAmt, noiseAmt);
-            vecMod.y += ofMap(ofSignedNoise(noiseScale * vecMod.y, noiseScale * vecMod.z, noiseRadius * sin(TWO_PI * t), noiseRadius * cos(TWO_PI * t)), -1, 1, -noiseAmt, noiseAmt);
-            
-            // And set the vertex add the index to our modulated vertex
-            delaunayMesh.setVertex(i, vecMod);
-            wireframeMesh.setVertex(i, vecMod);
-        }
-        else if (!bNoiseMode){
-            
-            vecMod.x += ofMap(ofSignedNoise(noiseScale * vecMod.x, noiseScale * vecMod.y, noiseRadius * sin(TWO_PI * t), noiseRadius * cos(TWO_PI * t)), -1, 1, -noiseAmt, noiseAmt);
-            vecMod.y += ofMap(ofSignedNoise(noiseScale * vecMod.x, noiseScale * vecMod.y, noiseRadius * sin(TWO_PI * t), noiseRadius * cos(TWO_PI * t)), -1, 1, -noiseAmt, noiseAmt);
-            
-            delaunayMesh.setVertex(i, vecMod);
-            wireframeMesh.setVertex(i, vecMod);
-        }
+    bench.begin("modulateDelaunay");
+    
+    MeshOutput& output = meshing.getOutput();
+    
+    // The loop terms are the same for every vertex, so work them out once
+    // and displace the lot in batches across the pool. Add 4D noise to each
+    // x/y rest position, looked up from (x, z) and (y, z) or from (x, y) twice.
+    float t = 1.0 * (getLoopTime()) / loopDuration;
+    NoiseKernels::Displacement displacement;
+    displacement.scale = noiseScale;
+    displacement.amount = noiseAmt;
+    displacement.loopZ = noiseRadius * sin(TWO_PI * t);
+    displacement.loopW = noiseRadius * cos(TWO_PI * t);
+    displacement.bXZ = bNoiseMode;
+    
+    // Look the noise up in this scene's baked volume, working it out
+    // directly until it's ready
+    shared_ptr<const NoiseVolume> volume;
+    if (bBakedNoise){
+        NoiseVolume::Key key = getNoiseKey();
+        requestNoiseVolume(key);
+        volume = noiseVolumes.get(key);
     }
     
-    bSceneChanged = false;
+    if (!output.rest.empty()){
+        vector<ofVec3f>& vertices = output.mesh.getVertices();
+        modulator.modulate(&output.rest[0], &vertices[0], vertices.size(), displacement, volume.get(), t);
+    }
+    
+    bench.end("modulateDelaunay");
 }
 
 void ofApp::theDirector(){
@@ -362,6 +371,9 @@ void ofApp::theDirector(){
         depthFar = 1300;
     }
     
+    // Start baking the new scene's noise while the last one's still showing
+    if (bSceneChanged && bBakedNoise) requestNoiseVolume(getNoiseKey());
+    
     if (!bPresentationMode){
         bDrawDebug = true;
         cam.enableMouseInput();
@@ -383,18 +395,26 @@ void ofApp::theDirector(){
 
 void ofApp::draw(){
 
+    if (bHeadless || !bSetUp) return;
+    
+    bench.begin("draw");
+    
     if (bEnableFX) postfx.begin(cam);
     if (bDrawAxis) drawAxis();
     
     drawDelaunay();
     
     if (bEnableFX) postfx.end();
+    
+    bench.end("draw");
     if (bDrawDebug) drawDebug(); ofSetWindowTitle(ofToString(ofGetFrameRate()));
     
 }
 
 void ofApp::drawDelaunay(){
     
+    ofVboMesh& delaunayMesh = meshing.getOutput().mesh;
+    
     cam.begin();
     
     push();
@@ -404,6 +424,17 @@ void ofApp::drawDelaunay(){
     ofScale(ofPoint(3));
     ofFill();
     
+    // Displace the mesh as it's drawn, the way modulateDelaunay() would have.
+    // Faces, wireframe and points all go through it.
+    if (bGpuNoise){
+        noiseShader.begin();
+        noiseShader.setUniform1f("noiseScale", noiseScale);
+        noiseShader.setUniform1f("noiseRadius", noiseRadius);
+        noiseShader.setUniform1f("noiseAmt", noiseAmt);
+        noiseShader.setUniform1f("loopPhase", fmod(getLoopTime(), loopDuration) / loopDuration);
+        noiseShader.setUniform1i("noiseMode", bNoiseMode);
+    }
+    
     if (bFaces || bDelusion){
         bPoints = false;
         bWireframe = false;
@@ -420,7 +451,7 @@ void ofApp::drawDelaunay(){
         ofPushMatrix();
         ofTranslate(0, 0,0.5);
         glLineWidth(3);
-        wireframeMesh.drawWireframe();
+        delaunayMesh.drawWireframe(); // Same vertex buffer as the faces, drawn as lines
         ofPopMatrix();
         glPushAttrib(GL_ALL_ATTRIB_BITS);
         glPointSize(5);
@@ -429,6 +460,8 @@ void ofApp::drawDelaunay(){
         glPopAttrib();
     }
     
+    if (bGpuNoise) noiseShader.end();
+    
     pop();
     
     cam.end();
@@ -443,8 +476,8 @@ void ofApp::captureFace() {
     // extrude a plane in Z space, and manipulate from there.
     
     // Causes occasional OfPixel errors....
-    //capturedFaceColor.setFromPixels(kinectColor.getPixels());
-    //capturedFaceDepth.setFromPixels(kinectDepth.getPixels());
+    //capturedFaceColor.setFromPixels(capture.getFrame().color);
+    //capturedFaceDepth.setFromPixels(capture.getFrame().depth);
 //
     capturedFaceColor.crop(cropX-cropW/2.0,
                            cropY-cropH/2.0,
@@ -458,15 +491,24 @@ void ofApp::captureFace() {
     // Rather than looking thorugh the whole kinect image,
     // need to just grab the face pixels
     
-    for(int x = 0; x < kinect.width; x += spacing) {
-        for(int y = 0; y < kinect.height; y += spacing) {
+    const KinectFrame& frame = capture.getFrame();
+    if (!frame.rawDepth.isAllocated()) return;
+    
+    // Unproject a sampled row at a time through the projection table
+    int samplesPerRow = (frame.getWidth() + spacing - 1) / spacing;
+    vector<ofVec3f> row(samplesPerRow);
+    
+    for(int y = 0; y < frame.getHeight(); y += spacing) {
+        const unsigned short* depthRow = frame.rawDepth.getData() + y * frame.getWidth();
+        projection.unprojectRow(depthRow, y, 0, spacing, samplesPerRow, &row[0]);
+        
+        for(int i = 0; i < samplesPerRow; i++) {
             
-            float distance = kinect.getDistanceAt(x, y);
+            ofVec3f wc = row[i];
 
-            if(distance > depthNear && distance < depthFar)
+            if(wc.z > depthNear && wc.z < depthFar)
             {
-                ofVec3f wc = kinect.getWorldCoordinateAt(x, y);
-                generatedMesh.addColor(kinect.getColorAt(x, y));
+                generatedMesh.addColor(frame.getColorAt(i * spacing, y));
                 wc.z = -wc.z;
                 
                 mesh.addVertex(wc);
@@ -475,7 +517,7 @@ void ofApp::captureFace() {
         }
     }
     bFaceCaptured = true;
-    tracker.reset();
+    faceTracker.reset();
 }
 
 
@@ -560,17 +602,81 @@ void ofApp::initBG(){
                             // H E L P E R S //
                             ///////////////////
 
-void ofApp::initKinect(){
+bool ofApp::initKinect(){
     
     angle = 0;
-    kinect.setRegistration(true);
-    kinect.init();
-    kinect.open();
-    kinect.setDepthClipping(depthNear, depthFar);
-    kinect.setCameraTiltAngle(angle);
-    
-    kinectColor.allocate(kinect.width, kinect.height);
-    kinectDepth.allocate(kinect.width, kinect.height);
+    
+    // Either the real thing or a recorded session
+    if (replayPath.empty()){
+        kinect = make_shared<LiveKinectSource>();
+    }
+    else {
+        replay = make_shared<ReplayKinectSource>(replayPath, replayRate, replayFps);
+        replay->setLoop(!bHeadless);
+        bDeterministic = replay->isDeterministic();
+        kinect = replay;
+    }
+    
+    // A recording that won't open leaves a 0x0 source that everything
+    // downstream would size itself from. Headless there's nothing to do but
+    // quit; with a window, show the kinect instead.
+    if (!kinect->open() && replay){
+        if (bHeadless){
+            ofLogError("ofApp") << "couldn't open " << replayPath << ", exiting";
+            ofExit(1);
+            return false;
+        }
+        ofLogWarning("ofApp") << "couldn't open " << replayPath << ", falling back to the kinect";
+        replay.reset();
+        bDeterministic = false;
+        kinect = make_shared<LiveKinectSource>();
+        kinect->open();
+    }
+    kinect->setDepthClipping(depthNear, depthFar);
+    kinect->setCameraTiltAngle(angle);
+    
+    // Work out the depth to world projection once for this resolution
+    projection.setup(*kinect);
+    
+    // Capture off the GL thread, unless we're replaying deterministically and
+    // need every frame in order
+    capture.setup(kinect, !bDeterministic);
+    capture.start();
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::toggleRecording(){
+    
+    if (recorder.isRecording()){
+        recorder.stop();
+    }
+    else {
+        ofDirectory::createDirectory("recordings", true, true);
+        recorder.start("recordings/" + ofGetTimestampString() + ".cgrs",
+                       kinect->getWidth(), kinect->getHeight(), kinect->getWorldScale());
+    }
+}
+
+//--------------------------------------------------------------
+bool ofApp::runBenchmarks(){
+    
+    Benchmarks::Settings settings;
+    settings.depthNear = depthNear;
+    settings.depthFar = depthFar;
+    settings.noiseScale = noiseScale;
+    settings.noiseRadius = noiseRadius;
+    settings.noiseAmt = noiseAmt;
+    return Benchmarks::runAll(capture.getFrame(), settings);
+}
+
+//--------------------------------------------------------------
+float ofApp::getLoopTime(){
+    
+    // A deterministic replay steps the clock by frames rather than wall time,
+    // so the noise modulation comes out the same on every run.
+    if (bDeterministic) return timer / replayFps;
+    return ofGetElapsedTimef();
 }
 
 void ofApp::initGUI(){
@@ -602,6 +708,28 @@ void ofApp::initPostFX(){
     postfx.setFlip(false);
 }
 
+void ofApp::initShaders(){
+    
+    // Only GLSL 1.20, so software GL can run it too. Without it the CPU
+    // does the displacement. Deterministic replays always do, so the
+    // checksum covers the displaced mesh.
+    if (noiseShader.load("shaders/noiseDisplace")){
+        bGpuNoise = !bDeterministic;
+        
+        // It hashes with the same permutation as the CPU, so both displace
+        // by the same field. It never changes, so it's set once.
+        float perm[256];
+        const int* permutation = NoiseKernels::getPermutation();
+        for (int i = 0; i < 256; i++) perm[i] = permutation[i];
+        noiseShader.begin();
+        noiseShader.setUniform4fv("perm", perm, 64);
+        noiseShader.end();
+    }
+    else {
+        ofLogWarning("ofApp") << "couldn't load the noise shader, displacing on the CPU";
+    }
+}
+
 void ofApp::drawDebug(){
     
     // Fairly self explanatory debug display.
@@ -609,11 +737,24 @@ void ofApp::drawDebug(){
     ofDisableDepthTest();
     push();
     
+    // Only upload what's changed since we last drew
+    const KinectFrame& frame = capture.getFrame();
+    if (frame.index != debugFrameIndex && frame.color.isAllocated()){
+        colorTexture.loadData(frame.color);
+        depthTexture.loadData(frame.depth);
+        debugFrameIndex = frame.index;
+    }
+    if (bMaskChanged){
+        const ofPixels& mask = meshing.getOutput().mask;
+        if (mask.isAllocated()) maskTexture.loadData(mask);
+        bMaskChanged = false;
+    }
+    
     ofSetColor(255, 255, 255);
     ofScale(.4, .4);
-    kinectColor.draw(0, 0);     // Raw kinect RGB image
-    kinectDepth.draw(0, 480);   // Raw kinect depth image
-    blob.draw(0, 960);          // Draw the image we are using to calculate the delaunay
+    if (colorTexture.isAllocated()) colorTexture.draw(0, 0);    // Raw kinect RGB image
+    if (depthTexture.isAllocated()) depthTexture.draw(0, 480);  // Raw kinect depth image
+    if (maskTexture.isAllocated()) maskTexture.draw(0, 960);    // Draw the image we are using to calculate the delaunay
     
     if(bFaceCaptured) {
         //ofSetColor(0, 0, 0, 150);
@@ -628,7 +769,17 @@ void ofApp::drawDebug(){
     ofSetRectMode(OF_RECTMODE_CENTER);
     ofDrawRectangle(cropX, cropY, cropW, cropH);// Draw the face capture
     ofSetColor(255, 255, 255, 100);
-    tracker.draw();                             // Draw the tracker
+    const FaceSnapshot& face = faceTracker.getSnapshot();
+    ofPushMatrix();
+    ofTranslate(face.searchArea.x, face.searchArea.y);
+    for (size_t i = 0; i < face.features.size(); i++){
+        face.features[i].draw();                // Draw the tracker
+    }
+    ofPopMatrix();
+    ofNoFill();
+    ofSetRectMode(OF_RECTMODE_CORNER);
+    ofDrawRectangle(face.searchArea.x, face.searchArea.y,
+                    face.searchArea.width, face.searchArea.height); // And where it was looking
     pop();
 
     push();
@@ -652,7 +803,7 @@ void ofApp::drawDebug(){
     else{ noiseMode = "X, Y, X, Y"; }
     ofTranslate(0, nudgeY);
     ofDrawBitmapString("numVerts:", 0, nudgeY);
-    ofDrawBitmapString(ofToString(delaunayMesh.getVertices().size()), nudgeX, nudgeY);
+    ofDrawBitmapString(ofToString(meshing.getOutput().mesh.getNumVertices()), nudgeX, nudgeY);
     ofDrawBitmapString("noiseScale:", 0, nudgeY*2);
     ofDrawBitmapString(ofToString(noiseScale), nudgeX, nudgeY*2);
     ofDrawBitmapString("noiseRadius:", 0, nudgeY*3);
@@ -668,6 +819,10 @@ void ofApp::drawDebug(){
     ofDrawBitmapString(ofToString(depthNear), nudgeX, nudgeY*8);
     ofDrawBitmapString("KinectDepthFar:", 0, nudgeY*9);
     ofDrawBitmapString(ofToString(depthFar), nudgeX, nudgeY*9);
+    if (recorder.isRecording()){
+        ofDrawBitmapString("Recording:", 0, nudgeY*10);
+        ofDrawBitmapString(ofToString(recorder.getNumFrames()) + " (" + ofToString(recorder.getNumDropped()) + " dropped)", nudgeX, nudgeY*10);
+    }
     
     pop();
     
@@ -755,6 +910,10 @@ void ofApp::keyPressed(int key){
             bPoints = !bPoints;
             break;
                 
+        case 't': // Track the face in a window around its last position, or the whole frame
+            faceTracker.setRoiEnabled(!faceTracker.getRoiEnabled());
+            break;
+                
             case 'n': // Switch noise mode (X, Y, X, Y) || (X, Z, Y, Z)
             bNoiseMode = !bNoiseMode;
             break;
@@ -780,25 +939,65 @@ void ofApp::keyPressed(int key){
             break;
                 
         case 'o': // Open the connection to the kinect (in case it bugs out)
-            kinect.setCameraTiltAngle(angle); // go back to prev tilt
-            kinect.open();
+            kinect->setCameraTiltAngle(angle); // go back to prev tilt
+            capture.open();
             break;
                 
         case 'c': // Close the connection to the kinect (refresh the image)
-            kinect.setCameraTiltAngle(0); // zero the tilt
-            kinect.close();
+            kinect->setCameraTiltAngle(0); // zero the tilt
+            capture.close();
+            break;
+                
+        case 's': // Start / stop recording the kinect to data/recordings
+            toggleRecording();
+            break;
+                
+        case 'b': // Log the pipeline timings so far and start counting again
+            bench.report();
+            bench.reset();
+            meshing.reportBench();
+            meshing.resetBench();
+            break;
+                
+        case 'i': // Tiled, parallel and incremental delaunay, or the whole image at once
+            bTiledDelaunay = !bTiledDelaunay;
+            break;
+                
+        case 'g': // Mesh straight off the sampling grid instead of the delaunay
+            bGridMesher = !bGridMesher;
+            break;
+                
+        case 'q': // Sample where the detail is, under a vertex budget, or on a grid
+            bAdaptiveSampling = !bAdaptiveSampling;
+            break;
+                
+        case 'v': // Displace the mesh in the vertex shader or on the CPU
+            bGpuNoise = !bGpuNoise && noiseShader.isLoaded();
+            
+            // The shader starts from the rest positions
+            if (bGpuNoise){
+                meshing.getOutput().mesh.getVertices() = meshing.getOutput().rest;
+            }
+            break;
+                
+        case 'k': // Look the noise up in a baked volume or work it out per vertex
+            bBakedNoise = !bBakedNoise;
+            break;
+                
+        case 'm': // Microbenchmark the kernels on the current frame
+            runBenchmarks();
             break;
                 
         case OF_KEY_UP: // Increase / decrease tilt of the kinect, ideally keep this at eye level
             angle++;
             if(angle > 30) angle = 30;
-            kinect.setCameraTiltAngle(angle);
+            kinect->setCameraTiltAngle(angle);
             break;
             
         case OF_KEY_DOWN:
             angle--;
             if(angle < -30) angle = -30;
-            kinect.setCameraTiltAngle(angle);
+            kinect->setCameraTiltAngle(angle);
             break;
             
         case OF_KEY_LEFT: // Clip the depth image near / far
@@ -4,7 +4,20 @@
 #include "ofxFaceTracker.h"
 #include "ofxOpenCv.h"
 #include "ofxKinect.h"
-#include "ofxDelaunay.h"
+#include "KinectSource.h"
+#include "ReplayKinectSource.h"
+#include "KinectRecording.h"
+#include "CaptureThread.h"
+#include "FaceTrackerThread.h"
+#include "PipelineBench.h"
+#include "MeshingThread.h"
+#include "ThreadPool.h"
+#include "DensityController.h"
+#include "Benchmarks.h"
+#include "DepthProjection.h"
+#include "NoiseKernels.h"
+#include "MeshModulator.h"
+#include "NoiseVolumeCache.h"
 #include "ofxPostProcessing.h"
 #include "ofxGUI.h"
 #include "ofxCameraSaveLoad.h"
@@ -13,14 +26,19 @@ class ofApp : public ofBaseApp{
 
 	public:
 		void setup();
+		void exit();
         void initCamera(int num);
         void initBG();
         void initGUI();
         void initPostFX();
-        void initKinect();
+        void initShaders();
+        bool initKinect();
     
         void updateFaceGrabber();
         void updateDelaunay();
+        MeshSettings getMeshSettings();
+        NoiseVolume::Key getNoiseKey();
+        void requestNoiseVolume(const NoiseVolume::Key& key);
         void modulateDelaunay();
 		void update();
     
@@ -40,9 +58,26 @@ class ofApp : public ofBaseApp{
         void push();
         void pop();
     
+        float getLoopTime();
+        bool runBenchmarks();
+        void toggleRecording();
+    
+    // Set from the command line in main()
+    string replayPath;          // Play back a recording instead of the live kinect
+    ReplayRate replayRate = REPLAY_NATIVE;
+    float replayFps = 30;
+    bool bHeadless = false;     // No window: run the recording once, report and quit
+    bool bStartRealTime = false;
+    float targetFps = 30;       // What the density controller aims for
+    string recordPath;          // Start recording to this file straight away
+    
     // Face tracking and kinect
-    ofxKinect kinect;
-    ofxFaceTracker tracker;
+    FaceTrackerThread faceTracker;
+    shared_ptr<KinectSource> kinect;
+    shared_ptr<ReplayKinectSource> replay; // Same source as kinect when replaying, otherwise null
+    CaptureThread capture;
+    DepthProjection projection;
+    KinectRecorder recorder;
     
     int cropX;
     int cropY;
@@ -53,11 +88,16 @@ class ofApp : public ofBaseApp{
     int captureFaceTimer;
     int captureFaceTimerMax;
     
-    ofxCvColorImage kinectColor;
-    ofxCvGrayscaleImage kinectDepth;
     ofImage capturedFaceColor;
     ofImage capturedFaceDepth;
-    ofImage blob;
+    float coverageThreshold = 0.5;  // Fraction of a triangle's bounding box that has to be on the mask
+    
+    // Debug view, uploaded straight from the current frame only when it's shown
+    ofTexture colorTexture;
+    ofTexture depthTexture;
+    ofTexture maskTexture;
+    int debugFrameIndex = -1;
+    bool bMaskChanged = false;
     
     const float ratio = 1.4;
     const float pixelScale = 55.0;
@@ -72,9 +112,8 @@ class ofApp : public ofBaseApp{
     ofMesh generatedMesh;
     ofMesh mesh;
     
-    ofxDelaunay del;
-    ofVboMesh delaunayMesh;
-    ofVboMesh wireframeMesh;
+    MeshingThread meshing;          // Builds the delaunay mesh, which faces, wireframe and points all draw from
+    bool bMeshPending = false;      // A portrait the mesher hasn't taken yet
     
     // Lights
     ofLight pointLight;
@@ -86,16 +125,37 @@ class ofApp : public ofBaseApp{
     float noiseRadius;
     float noiseScale;
     float noiseAmt;
+    const float loopDuration = 24; // Seconds, the noise animation repeats after this
+    ofShader noiseShader;       // The same displacement, done as the mesh is drawn
+    bool bGpuNoise = false;     // Displace in the vertex shader, leaving the mesh at rest
+    MeshModulator modulator;
+    ThreadPool modulationPool;  // Its own, the meshing thread has threadPool busy while we draw
+    NoiseVolumeCache noiseVolumes;
+    NoiseVolume::Key requestedNoiseKey = NoiseVolume::Key();   // The last volume asked for
+    bool bBakedNoise = true;    // Look the noise up in a baked volume once there is one
     
     int spacing = 3;
+    int vertexBudget = 6000;        // For the adaptive sampler
     int timer = 0;
     
+    ThreadPool threadPool;
+    DensityController density;
+    bool bDensityControl = false;
+    
+    // Profiling
+    PipelineBench bench;
+    bool bDeterministic = false; // Replaying at max speed, drive time from the frame count
+    bool bSetUp = false;        // False if setup() gave up, the app is on its way out
+    
     // Palette
     ofColor *colors;
     int desatVal;
     
     // Functional Booleans
     bool bIsRealTime; // If not real time, then portrait mode
+    bool bTiledDelaunay = true; // Triangulate in tiles on the thread pool, rather than in one piece
+    bool bGridMesher = false; // Mesh the sampling grid directly, no delaunay
+    bool bAdaptiveSampling = false; // Quadtree sampling rather than every `spacing` pixels
     bool bWireframe;
     bool bFaces;
     bool bPoints;
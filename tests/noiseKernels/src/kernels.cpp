@@ -0,0 +1,3 @@
+// The app's kernels, built straight from its source rather than copied
+#include "../../../src/DepthKernels.cpp"
+#include "../../../src/NoiseKernels.cpp"
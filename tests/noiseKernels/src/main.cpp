@@ -0,0 +1,125 @@
+#include "ofMain.h"
+#include "../../../src/NoiseKernels.h"
+
+// Every version of the noise kernels this machine can run, SSE2 and AVX2 on
+// Intel or NEON on ARM, against ofSignedNoise(), the noise the app displaced
+// by before they existed. Exits with the number of checks that
+// failed, so 0 means they all agree.
+
+static const float NOISE_TOLERANCE = 1e-5;    // How far the kernels may stray from ofSignedNoise()
+static const int SAMPLES = 100000;
+
+static int failures = 0;
+
+static void check(bool bPassed, const string& name, float worst){
+    ofLogNotice("noiseKernels") << (bPassed ? "pass " : "FAIL ") << name << ", off by up to " << worst;
+    if (!bPassed) failures++;
+}
+
+// Points spread over everything the mesh and the loop terms can reach, with
+// some right on the lattice, where the cell floors are easiest to get wrong
+static void makePoints(vector<float>& x, vector<float>& y, vector<float>& z, vector<float>& w){
+    x.resize(SAMPLES);
+    y.resize(SAMPLES);
+    z.resize(SAMPLES);
+    w.resize(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++){
+        float range = i % 4 == 0 ? 20 : 4;
+        x[i] = ofRandom(-range, range);
+        y[i] = ofRandom(-range, range);
+        z[i] = ofRandom(-5, 5);
+        w[i] = ofRandom(-5, 5);
+        if (i % 97 == 0){
+            x[i] = floor(x[i]);
+            y[i] = 0;
+        }
+    }
+}
+
+static void checkNoise(){
+    vector<float> x, y, z, w;
+    makePoints(x, y, z, w);
+
+    float worst = 0;
+    for (int i = 0; i < SAMPLES; i++){
+        worst = max(worst, fabs(NoiseKernels::signedNoise(x[i], y[i], z[i], w[i]) - ofSignedNoise(x[i], y[i], z[i], w[i])));
+    }
+    check(worst <= NOISE_TOLERANCE, "scalar signedNoise()", worst);
+
+    // The batches share their loop terms, so a handful of them
+    vector<float> noise(SAMPLES);
+    for (int set = DepthKernels::SCALAR; set <= DepthKernels::NEON; set++){
+        DepthKernels::InstructionSet s = (DepthKernels::InstructionSet)set;
+        if (!DepthKernels::isAvailable(s)) continue;
+        float worst = 0;
+        for (int loop = 0; loop < 8; loop++){
+            NoiseKernels::signedNoise(&x[0], &y[0], z[loop], w[loop], SAMPLES, &noise[0], s);
+            for (int i = 0; i < SAMPLES; i++){
+                worst = max(worst, fabs(noise[i] - ofSignedNoise(x[i], y[i], z[loop], w[loop])));
+            }
+        }
+        check(worst <= NOISE_TOLERANCE, DepthKernels::getName(s) + " batched signedNoise()", worst);
+    }
+}
+
+static void checkDisplacement(){
+    const float scale = 0.01;
+    const float radius = 2.5;
+    const float amount = 30;
+    const float t = 0.37;
+
+    // A depth image's worth of vertices, centred and pushed back
+    vector<ofVec3f> rest(SAMPLES);
+    for (int i = 0; i < SAMPLES; i++){
+        rest[i].set(ofRandom(-320, 320), ofRandom(-240, 240), -ofRandom(5, 1300));
+    }
+
+    for (int mode = 0; mode < 2; mode++){
+
+        // The loop modulateDelaunay() used to run, one vertex at a time
+        vector<ofVec3f> reference = rest;
+        float loopZ = radius * sin(TWO_PI * t);
+        float loopW = radius * cos(TWO_PI * t);
+        for (size_t i = 0; i < reference.size(); i++){
+            ofVec3f& p = reference[i];
+            if (mode){
+                p.x += ofMap(ofSignedNoise(scale * p.x, scale * p.z, loopZ, loopW), -1, 1, -amount, amount);
+                p.y += ofMap(ofSignedNoise(scale * p.y, scale * p.z, loopZ, loopW), -1, 1, -amount, amount);
+            }
+            else {
+                p.x += ofMap(ofSignedNoise(scale * p.x, scale * p.y, loopZ, loopW), -1, 1, -amount, amount);
+                p.y += ofMap(ofSignedNoise(scale * p.x, scale * p.y, loopZ, loopW), -1, 1, -amount, amount);
+            }
+        }
+
+        NoiseKernels::Displacement displacement;
+        displacement.scale = scale;
+        displacement.amount = amount;
+        displacement.loopZ = loopZ;
+        displacement.loopW = loopW;
+        displacement.bXZ = mode;
+
+        for (int set = DepthKernels::SCALAR; set <= DepthKernels::NEON; set++){
+            DepthKernels::InstructionSet s = (DepthKernels::InstructionSet)set;
+            if (!DepthKernels::isAvailable(s)) continue;
+            vector<ofVec3f> displaced = rest;
+            NoiseKernels::displace(&displaced[0].x, displaced.size(), displacement, s);
+
+            float worst = 0;
+            for (size_t i = 0; i < displaced.size(); i++){
+                worst = max(worst, displaced[i].distance(reference[i]));
+            }
+            check(worst <= NOISE_TOLERANCE * amount,
+                  DepthKernels::getName(s) + (mode ? " (x, z) (y, z)" : " (x, y) twice") + " displace()", worst);
+        }
+    }
+}
+
+//========================================================================
+int main(){
+    ofSeedRandom(0);
+    checkNoise();
+    checkDisplacement();
+    if (failures > 0) ofLogError("noiseKernels") << failures << " checks failed";
+    return failures;
+}